@@ -46,6 +46,30 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 // Change the total fonts included
 #define TOTALFONTS		4
 
+// Instrumentation hooks, compiled out unless MICROOLED_STATS is defined
+#ifdef MICROOLED_STATS
+#define STAT_ADD(field, n)		(stats.field += (n))
+#define STAT_FLUSH_BEGIN()		statsFlushBegin()
+#define STAT_FLUSH_END(bytes)	statsFlushEnd(bytes)
+#else
+#define STAT_ADD(field, n)
+#define STAT_FLUSH_BEGIN()
+#define STAT_FLUSH_END(bytes)
+#endif
+
+/** \brief Hash of a screen buffer page.
+
+    32-bit FNV-1a over the LCDWIDTH bytes of a page, used by display() to recognise pages the controller already holds.
+*/
+static uint32_t pageHash(const uint8_t *page) {
+	uint32_t hash = 2166136261u;
+
+	for (uint8_t x = 0; x < LCDWIDTH; x++) {
+		hash = (hash ^ page[x]) * 16777619u;
+	}
+	return hash;
+}
+
 // Add the font name as declared in the header file.
 unsigned const char *MicroOLED::fontsPointer[]={
 	font5x7
@@ -58,8 +82,26 @@ unsigned const char *MicroOLED::fontsPointer[]={
 
 Page buffer LCDWIDTH x LCDHEIGHT divided by 8
 Page buffer is required because in SPI mode, the host cannot read the SSD1306's GDRAM of the controller.  This page buffer serves as a scratch RAM for graphical functions.  All drawing function will first be drawn on this page buffer, only upon calling display() function will transfer the page buffer to the actual LCD controller's memory.
+Built with MICROOLED_PAGEMODE the buffer holds a single page, which drawPages() renders the screen into one strip at a time.
+*/
+#ifdef MICROOLED_PAGEMODE
+#define SCREENBUFFERSIZE	LCDWIDTH
+#else
+#define SCREENBUFFERSIZE	(LCDWIDTH * LCDHEIGHT / 8)
+#endif
+static uint8_t screenmemory [SCREENBUFFERSIZE]; 
+
+// First display page held in the screen buffer: always 0 with the full frame, the page being rendered by
+// drawPages() in page mode (rows outside the strip are clipped and never touched)
+static uint8_t bufferPage0 = 0;
+
+/** \brief Screen buffer index.
+
+    Index of column x of display page page in the screen buffer.
 */
-static uint8_t screenmemory [LCDWIDTH * LCDHEIGHT / 8]; 
+static inline int16_t bufferIndex(int16_t x, int16_t page) {
+	return x + (page - bufferPage0) * LCDWIDTH;
+}
 	/* SSD1306 Memory organised in 128 horizontal pixel and 8 rows of byte
 	 B  B .............B  -----
 	 y  y .............y        \
@@ -77,25 +119,36 @@ static uint8_t screenmemory [LCDWIDTH * LCDHEIGHT / 8];
 	 D7 D7.............D7  ----
 	*/
 
+/** \brief SSD1306 initialisation sequence.
+
+    Commands sent by init() for the 64x48 OLED module. The shadow state set in init() must match the contrast, display mode, remap and scan direction chosen here.
+*/
+static constexpr uint8_t initSequence[] = {
+	DISPLAYOFF,					// 0xAE
+	SETDISPLAYCLOCKDIV, 0x80,	// 0xD5, the suggested ratio 0x80
+	SETMULTIPLEX, 0x2F,			// 0xA8, 47(0x2F)
+	SETDISPLAYOFFSET, 0x0,		// 0xD3, no offset
+	SETSTARTLINE | 0x0,			// line #0
+	CHARGEPUMP, 0x14,			// enable charge pump
+	NORMALDISPLAY,				// 0xA6
+	DISPLAYALLONRESUME,			// 0xA4
+	SEGREMAP | 0x1,
+	COMSCANDEC,
+	SETCOMPINS, 0x12,			// 0xDA, 0x12 if height > 32 else 0x02
+	SETCONTRAST, 0x8F,			// 0x81, 0x8F
+	SETPRECHARGE, 0xF1,			// 0xd9, 0xF1
+	SETVCOMDESELECT, 0x40,		// 0xDB
+	MEMORYMODE, 0,				// 0x20, horizontal addressing mode, never changed afterwards
+	DISPLAYON					//--turn on oled panel
+};
+
 /** \brief Initialisation of MicroOLED Library.
 
-    Setup IO pins and parameters for SPI then send initialisation commands to the SSD1306 controller inside the OLED. 
+    Setup IO pins and parameters for SPI then send initialisation commands to the SSD1306 controller inside the OLED. Blocks for about 20ms while the display is reset, see initAsync() for a non-blocking alternative.
 */
 void MicroOLED::init(int spi_mode, int spi_freq) 
 {	
-	// default 5x7 font
-	setFontType(0);
-	setColor(WHITE);
-	setDrawMode(NORM);
-	setCursor(0,0);
-  
-	memset(screenmemory,0,(LCDWIDTH * LCDHEIGHT / 8));  // initially clear Page buffer
-
-	// Initialize the SPI library:
-	dcPin = 0;
-	csPin = 1;
-	miol_spi.format(8, spi_mode);	// 8 Bit wide SPI and Mode (0 - 3)
-	miol_spi.frequency(spi_freq);	// SPI speed in Hz
+	initState(spi_mode, spi_freq);
 
 	// Display reset routine
 	rstPin = 1;						// Initially set RST HIGH
@@ -105,35 +158,123 @@ void MicroOLED::init(int spi_mode, int spi_freq)
 	rstPin = 1;						// Set RST HIGH, bring out of reset
 	ThisThread::sleep_for(5ms);		// wait 5ms
 
-	// Display Init sequence for 64x48 OLED module
-	command(DISPLAYOFF);				// 0xAE
+	initController();
+}
+
+/** \brief Non-blocking initialisation of MicroOLED Library.
+
+    Same as init(), but the reset waits are scheduled on queue instead of sleeping, so other peripherals can be brought up while the display resets. Every step, including the SPI transfers, runs from queue's dispatch context. ready (if given) is called from there once the controller is initialised; isReady() can be polled instead. Nothing may be drawn to the display before that. Return false if the first step could not be queued (queue full); nothing is scheduled then, and init() can be used instead. Later steps that find the queue full are posted again from a timeout until there is room, so the sequence always completes without blocking the dispatch context.
+*/
+bool MicroOLED::initAsync(EventQueue &queue, int spi_mode, int spi_freq, Callback<void()> ready)
+{
+	initState(spi_mode, spi_freq);
+
+	initQueue = &queue;
+	initReady = ready;
+	initStep = 0;
 
-	command(SETDISPLAYCLOCKDIV, 0x80);	// 0xD5, the suggested ratio 0x80
+	rstPin = 1;						// Initially set RST HIGH, then let VDD settle for 5 ms
+	return initQueue->call_in(5ms, callback(this, &MicroOLED::initAsyncStep)) != 0;
+}
+
+/** \brief Initialisation state.
 
-	command(SETMULTIPLEX, 0x2F);		// 0xA8, 47(0x2F)
+    Return true once init() or initAsync() has finished initialising the controller.
+*/
+bool MicroOLED::isReady(void) {
+	return readyState;
+}
 
-	command(SETDISPLAYOFFSET, 0x0);		// 0xD3, no offset
+/** \brief Advance the non-blocking reset sequence.
 
-	command(SETSTARTLINE | 0x0);		// line #0
+    Called from the event queue given to initAsync(), one call per reset step.
+*/
+void MicroOLED::initAsyncStep(void)
+{
+	switch (initStep++) {
+		case 0:
+			rstPin = 0;				// Bring RST low, reset the display for 10ms
+			initAsyncNext(10ms);
+			break;
+		case 1:
+			rstPin = 1;				// Set RST HIGH, bring out of reset and wait 5ms
+			initAsyncNext(5ms);
+			break;
+		default:
+			initController();
+			if (initReady)
+			initReady();
+			break;
+	}
+}
 
-	command(CHARGEPUMP, 0x14);			// enable charge pump
+/** \brief Schedule the next reset step.
 
-	command(NORMALDISPLAY);				// 0xA6
-	command(DISPLAYALLONRESUME);		// 0xA4
+    Queue initAsyncStep() after delay. If the queue is full, let a timeout post the step once the delay has passed instead of dropping the sequence.
+*/
+void MicroOLED::initAsyncNext(std::chrono::milliseconds delay)
+{
+	if (initQueue->call_in(delay, callback(this, &MicroOLED::initAsyncStep)) == 0)
+	initRetry.attach(callback(this, &MicroOLED::initAsyncRetry), delay);
+}
 
-	command(SEGREMAP | 0x1);
-	command(COMSCANDEC);
+/** \brief Retry posting a reset step.
 
-	command(SETCOMPINS, 0x12);			// 0xDA, 0x12 if height > 32 else 0x02
+    Timeout handler: post initAsyncStep() to the queue, trying again a millisecond later while the queue is still full.
+*/
+void MicroOLED::initAsyncRetry(void)
+{
+	if (initQueue->call(callback(this, &MicroOLED::initAsyncStep)) == 0)
+	initRetry.attach(callback(this, &MicroOLED::initAsyncRetry), 1ms);
+}
 
-	command(SETCONTRAST, 0x8F);			// 0x81, 0x8F
+/** \brief Reset library state.
 
-	command(SETPRECHARGE, 0xF1);		// 0xd9, 0xF1
-	
-	command(SETVCOMDESELECT, 0x40);		// 0xDB
+    Set default font, color, draw mode and cursor, clear the screen buffer and configure SPI and the control pins. Shared by init() and initAsync().
+*/
+void MicroOLED::initState(int spi_mode, int spi_freq)
+{
+	readyState = false;
+#ifdef MICROOLED_STATS
+	resetStats();
+#endif
+	resetClip();
+
+	// default 5x7 font
+	setFontType(0);
+	setColor(WHITE);
+	setDrawMode(NORM);
+	setCursor(0,0);
+  
+	memset(screenmemory,0,SCREENBUFFERSIZE);  // initially clear Page buffer
+
+	// Initialize the SPI library:
+	dcPin = 0;
+	csPin = 1;
+	miol_spi.format(8, spi_mode);	// 8 Bit wide SPI and Mode (0 - 3)
+	miol_spi.frequency(spi_freq);	// SPI speed in Hz
+}
+
+/** \brief Initialise the controller.
+
+    Send the initialisation sequence to a freshly reset SSD1306 and clear its memory. Shared by init() and initAsync().
+*/
+void MicroOLED::initController(void)
+{
+	// Display Init sequence for 64x48 OLED module, sent under a single CS assertion
+	command(initSequence, sizeof(initSequence));
+	windowValid = false;
+	shadowPagesValid = 0;
+
+	// Record what the sequence above left in the controller
+	shadowContrast = 0x8F;
+	shadowInverted = false;
+	shadowFlipV = false;
+	shadowFlipH = false;
+	shadowScrolling = false;
 
-	command(DISPLAYON);					//--turn on oled panel
 	clear(ALL);							// Erase hardware memory inside the OLED controller to avoid random data in memory.
+	readyState = true;
 }
 
 /** \brief Send the display command byte(s)
@@ -141,127 +282,480 @@ void MicroOLED::init(int spi_mode, int spi_freq)
     Send command(s) via SPI to SSD1306 controller.
 */
 void MicroOLED::command(uint8_t c) {
-	
-	dcPin = 0;	// DC pin LOW for a command
-	csPin = 0;	// SS LOW to initialize transfer
-	miol_spi.write(c);			// Transfer the command byte
-	csPin = 1;	// SS HIGH to end transfer
-
+	command(&c, 1);
 }
 
 void MicroOLED::command(uint8_t c1, uint8_t c2) {
-	
-	dcPin = 0;	// DC pin LOW for a command
-	csPin = 0;	// SS LOW to initialize transfer
-	miol_spi.write(c1);			// Transfer the command byte
-    miol_spi.write(c2);			// Transfer the first parameter
-	csPin = 1;	// SS HIGH to end transfer
-
+	const uint8_t cmds[] = { c1, c2 };
+	command(cmds, sizeof(cmds));
 }
 
 void MicroOLED::command(uint8_t c1, uint8_t c2, uint8_t c3) {
-	
+	const uint8_t cmds[] = { c1, c2, c3 };
+	command(cmds, sizeof(cmds));
+}
+
+void MicroOLED::command(uint8_t c1, uint8_t c2, uint8_t c3, uint8_t c4, uint8_t c5, uint8_t c6, uint8_t c7, uint8_t c8) {
+	const uint8_t cmds[] = { c1, c2, c3, c4, c5, c6, c7, c8 };
+	command(cmds, sizeof(cmds));
+}
+
+/** \brief Send a sequence of command bytes.
+
+    Send len command bytes (commands and their parameters, back to back) via SPI to SSD1306 controller under a single CS assertion using the bulk SPI transfer.
+*/
+void MicroOLED::command(const uint8_t *cmds, size_t len) {
+	if (len == 0)
+	return;
+
 	dcPin = 0;	// DC pin LOW for a command
 	csPin = 0;	// SS LOW to initialize transfer
-	miol_spi.write(c1);			// Transfer the command byte
-    miol_spi.write(c2);			// Transfer the first parameter
-    miol_spi.write(c3);			// Transfer the second parameter
+	miol_spi.write((const char *)cmds, len, NULL, 0);
 	csPin = 1;	// SS HIGH to end transfer
-
+	STAT_ADD(commandTransfers, 1);
+	STAT_ADD(csAssertions, 1);
+	STAT_ADD(bytesSent, len);
 }
 
-void MicroOLED::command(uint8_t c1, uint8_t c2, uint8_t c3, uint8_t c4, uint8_t c5, uint8_t c6, uint8_t c7, uint8_t c8) {
-	
-	dcPin = 0;	// DC pin LOW for a command
+/** \brief Send display data bytes.
+
+    Bulk transfer len bytes into the controller's current address window and keep track of its address pointer.
+*/
+void MicroOLED::data(const uint8_t *buf, size_t len) {
+	dcPin = 1;	// DC pin HIGH for data
 	csPin = 0;	// SS LOW to initialize transfer
-	miol_spi.write(c1);			// Transfer the command byte
-    miol_spi.write(c2);			// Transfer the first parameter
-    miol_spi.write(c3);			// Transfer the second parameter
-    miol_spi.write(c4);			// Transfer the third parameter
-    miol_spi.write(c5);			// Transfer the fourth parameter
-    miol_spi.write(c6);			// Transfer the fifth parameter
-    miol_spi.write(c7);			// Transfer the sixth parameter
-    miol_spi.write(c8);			// Transfer the seventh parameter
+	miol_spi.write((const char *)buf, len, NULL, 0);
 	csPin = 1;	// SS HIGH to end transfer
+	advanceWindow(len);
+	STAT_ADD(csAssertions, 1);
+	STAT_ADD(bytesSent, len);
+}
+
+/** \brief Queue a command byte.
+
+    Append c to the queue, sending the queued bytes first if the queue is full.
+*/
+MicroOLED::CommandQueue &MicroOLED::CommandQueue::add(uint8_t c) {
+	if (count >= COMMANDQUEUESIZE)
+	flush();
+	buffer[count++] = c;
+	return *this;
+}
+
+MicroOLED::CommandQueue &MicroOLED::CommandQueue::add(uint8_t c1, uint8_t c2) {
+	return add(c1).add(c2);
+}
+
+MicroOLED::CommandQueue &MicroOLED::CommandQueue::add(uint8_t c1, uint8_t c2, uint8_t c3) {
+	return add(c1).add(c2).add(c3);
+}
+
+/** \brief Queue a sequence of command bytes.
+*/
+MicroOLED::CommandQueue &MicroOLED::CommandQueue::add(const uint8_t *cmds, size_t len) {
+	while (len--) {
+		add(*cmds++);
+	}
+	return *this;
+}
 
+/** \brief Send queued commands.
+
+    Send every queued byte to the controller under a single CS assertion and empty the queue.
+*/
+void MicroOLED::CommandQueue::flush(void) {
+	oled.command(buffer, count);
+	count = 0;
 }
 
 /** \brief Clear screen buffer or SSD1306's memory.
  
-    To clear all GDRAM inside the LCD controller, pass in the variable mode = ALL and to clear screen page buffer pass in the variable mode = PAGE.
+    To clear all GDRAM inside the LCD controller, pass in the variable mode = ALL and to clear screen page buffer pass in the variable mode = PAGE. Inside a drawPages() callback PAGE clears the current strip only.
 */
 void MicroOLED::clear(uint8_t mode) {
 	if (mode==ALL) {
-    	command(MEMORYMODE, 0, SETCOLUMNBOUNDS, 0, LCDTOTALWIDTH - 1, SETPAGEBOUNDS, 0, (LCDTOTALHEIGHT / 8) - 1); // Set horizontal addressing mode, width and height
-    	dcPin = 1;
-    	csPin = 0;
-		for (int i = 0; i < (LCDTOTALWIDTH * LCDTOTALHEIGHT / 8); i++) {
-			miol_spi.write(0);
-		}
-    	csPin = 1;
-    	command(MEMORYMODE, 2); // Restore to page addressing mode
+		fillController(0);
 	}
 	else
 	{
-		memset(screenmemory,0,(LCDWIDTH * LCDHEIGHT / 8));
+		memset(screenmemory + bufferIndex(0, stripY0 >> 3), 0, ((stripY1 - stripY0) >> 3) * LCDWIDTH);
 		//display();
 	}
 }
 
 /** \brief Clear or replace screen buffer or SSD1306's memory with a character.	
 
-	To clear GDRAM inside the LCD controller, pass in the variable mode = ALL with c character and to clear screen page buffer, pass in the variable mode = PAGE with c character.
+	To clear GDRAM inside the LCD controller, pass in the variable mode = ALL with c character and to clear screen page buffer, pass in the variable mode = PAGE with c character. Inside a drawPages() callback PAGE fills the current strip only and leaves sending it to drawPages().
 */
 void MicroOLED::clear(uint8_t mode, uint8_t c) {
 	if (mode==ALL) {
-		command(MEMORYMODE, 0, SETCOLUMNBOUNDS, 0, LCDTOTALWIDTH - 1, SETPAGEBOUNDS, 0, (LCDTOTALHEIGHT / 8) - 1); // Set horizontal addressing mode, width and height
-    	dcPin = 1;
-    	csPin = 0;
-		for (int i = 0; i < (LCDTOTALWIDTH * LCDTOTALHEIGHT / 8); i++) {
-			miol_spi.write(c);
-		}
-    	csPin = 1;
-    	command(MEMORYMODE, 2); // Restore to page addressing mode
+		fillController(c);
 	}
 	else
 	{
-		memset(screenmemory,c,(LCDWIDTH * LCDHEIGHT / 8));
+		memset(screenmemory + bufferIndex(0, stripY0 >> 3), c, ((stripY1 - stripY0) >> 3) * LCDWIDTH);
+#ifndef MICROOLED_PAGEMODE
+		if ((stripY0 == 0) && (stripY1 == LCDHEIGHT))	// drawPages() sends the strip itself
 		display();
+#endif
 	}	
 }
 
 /** \brief Invert display.
 
-    The WHITE color of the display will turn to BLACK and the BLACK will turn to WHITE.
+    The WHITE color of the display will turn to BLACK and the BLACK will turn to WHITE. Nothing is sent if the display is already in the requested state.
 */
 void MicroOLED::invert(boolean inv) {
+	if (inv == shadowInverted)
+	return;
+
 	if (inv)
 	command(INVERTDISPLAY);
 	else
 	command(NORMALDISPLAY);
+	shadowInverted = inv;
 }
 
 /** \brief Set contrast.
 
-    OLED contract value from 0 to 255. Note: Contrast level is not very obvious.
+    OLED contract value from 0 to 255. Note: Contrast level is not very obvious. Nothing is sent if the contrast is already set to this value.
 */
 void MicroOLED::contrast(uint8_t contrast) {
+	if (contrast == shadowContrast)
+	return;
+
 	command(SETCONTRAST, contrast);			// 0x81
+	shadowContrast = contrast;
+}
+
+/** \brief Resynchronise controller settings.
+
+    Re-send every setting kept in the shadow state (contrast, inversion, flips, addressing mode) unconditionally, stop any scrolling and forget the current address window and the page hashes, so the next display() sends everything. Call this after the panel has been reset behind the library's back, or after raw command() calls that changed these settings.
+*/
+void MicroOLED::resync(void) {
+	CommandQueue cmds(*this);
+
+	cmds.add(SETCONTRAST, shadowContrast);
+	cmds.add(shadowInverted ? INVERTDISPLAY : NORMALDISPLAY);
+	cmds.add(shadowFlipV ? COMSCANINC : COMSCANDEC);
+	cmds.add(shadowFlipH ? (SEGREMAP | 0x0) : (SEGREMAP | 0x1));
+	cmds.add(DEACTIVATESCROLL);
+	cmds.add(MEMORYMODE, 0);
+	cmds.flush();
+	shadowScrolling = false;
+	windowValid = false;
+	shadowPagesValid = 0;
 }
 
+#ifndef MICROOLED_PAGEMODE
 /** \brief Transfer display memory.
 
-    Bulk move the screen buffer to the SSD1306 controller's memory so that images/graphics drawn on the screen buffer will be displayed on the OLED.
+    Bulk move the screen buffer to the SSD1306 controller's memory so that images/graphics drawn on the screen buffer will be displayed on the OLED. Pages whose hash matches the one last sent by display() are skipped, and so is the whole transfer if nothing changed; runs of changed pages go out in one window each. Any other write to the controller (partial flushes, displayFrame(), clear(ALL), scrolling) makes display() send the pages it touched again. Call resync() if the controller memory was changed behind the library's back.
 */
 void MicroOLED::display(void) {
-	command(MEMORYMODE, 0, SETCOLUMNBOUNDS, LCDCOLUMNOFFSET, LCDCOLUMNOFFSET + LCDWIDTH - 1, SETPAGEBOUNDS, 0, (LCDHEIGHT / 8) - 1); // Set horizontal addressing mode, width and height
+	uint32_t hash[LCDHEIGHT / 8];
+	uint16_t bytes = 0;
+	uint8_t page = 0, unchanged = 0;
+
+	for (uint8_t p = 0; p < LCDHEIGHT / 8; p++) {
+		hash[p] = pageHash(screenmemory + p * LCDWIDTH);
+		if ((shadowPagesValid & (1 << p)) && (shadowPageHash[p] == hash[p]))
+		unchanged |= 1 << p;
+	}
+
+	STAT_FLUSH_BEGIN();
+	while (page < LCDHEIGHT / 8) {
+		uint8_t page1 = page;
+
+		if (unchanged & (1 << page)) {
+			page++;
+			continue;
+		}
+		while ((page1 + 1 < LCDHEIGHT / 8) && !(unchanged & (1 << (page1 + 1))))
+		page1++;
+
+		setWindow(LCDCOLUMNOFFSET, LCDCOLUMNOFFSET + LCDWIDTH - 1, page, page1);
+		data(screenmemory + page * LCDWIDTH, (page1 - page + 1) * LCDWIDTH);	// pages are contiguous in the screen buffer
+		bytes += (page1 - page + 1) * LCDWIDTH;
+		page = page1 + 1;
+	}
+	STAT_FLUSH_END(bytes);
+
+	memcpy(shadowPageHash, hash, sizeof(hash));
+	shadowPagesValid = (1 << (LCDHEIGHT / 8)) - 1;
+	dirtyCol0 = LCDWIDTH;	// everything is clean now
+}
+#endif
+
+/** \brief Transfer frame.
+
+    Bulk move a full LCDWIDTH x LCDHEIGHT page-major frame from frame instead of the screen buffer, on the same path as display(). Used to alternate between prepared frames (e.g. grayscale bit-planes) without copying them into the screen buffer. The screen buffer is no longer what the controller shows, so it is marked dirty as a whole.
+*/
+void MicroOLED::displayFrame(const uint8_t *frame) {
+	STAT_FLUSH_BEGIN();
+	setWindow(LCDCOLUMNOFFSET, LCDCOLUMNOFFSET + LCDWIDTH - 1, 0, (LCDHEIGHT / 8) - 1); // visible area
+	data(frame, LCDWIDTH * LCDHEIGHT / 8);
+	STAT_FLUSH_END(LCDWIDTH * LCDHEIGHT / 8);
+	markDirty(0, 0, LCDWIDTH, LCDHEIGHT);
+}
+
+/** \brief Transfer run-length encoded frame.
+
+    Decode a full frame in the format of SFE_MicroOLED_RLE.h straight to the SSD1306 controller's memory, RLECHUNKSIZE bytes at a time, without the screen buffer. Long runs of one byte (blank areas) are expanded on the fly, so a splash screen in flash costs its compressed size and a small stack buffer. The screen buffer is marked dirty as a whole, as with displayFrame(). Return a pointer just past the frame.
+*/
+const uint8_t *MicroOLED::displayRLE(const uint8_t *rle) {
+	uint8_t chunk[RLECHUNKSIZE];
+	RLEDecoder decoder;
+
+	STAT_FLUSH_BEGIN();
+	setWindow(LCDCOLUMNOFFSET, LCDCOLUMNOFFSET + LCDWIDTH - 1, 0, (LCDHEIGHT / 8) - 1); // visible area
+	rleBegin(decoder, rle);
+	for (uint16_t out = 0; out < LCDWIDTH * LCDHEIGHT / 8; out += RLECHUNKSIZE) {
+		uint16_t n = LCDWIDTH * LCDHEIGHT / 8 - out;
+
+		if (n > RLECHUNKSIZE) n = RLECHUNKSIZE;
+		rleRead(decoder, chunk, n, false);
+		data(chunk, n);
+	}
+	STAT_FLUSH_END(LCDWIDTH * LCDHEIGHT / 8);
+	markDirty(0, 0, LCDWIDTH, LCDHEIGHT);
+	return rleEnd(decoder);
+}
+
+#ifndef MICROOLED_PAGEMODE
+/** \brief Transfer part of display memory.
+
+    Move only the screen buffer area covering the width x height rectangle at x,y to the SSD1306 controller's memory. The area is widened to whole pages (8 pixel rows) and clipped to the screen.
+*/
+void MicroOLED::display(int16_t x, int16_t y, int16_t width, int16_t height) {
+	if (x < 0) {
+		width += x;
+		x = 0;
+	}
+	if (y < 0) {
+		height += y;
+		y = 0;
+	}
+	if (width > LCDWIDTH - x) width = LCDWIDTH - x;
+	if (height > LCDHEIGHT - y) height = LCDHEIGHT - y;
+	if ((width <= 0) || (height <= 0))
+	return;
+
+	flushWindow(x, x + width - 1, y / 8, (y + height - 1) / 8);
+}
+#endif
+
+/** \brief Mark screen buffer area as changed.
+
+    Add the width x height rectangle at x,y to the dirty region sent by the next displayDirty(). The dirty region is the bounding box, in columns and pages, of all marked rectangles.
+*/
+void MicroOLED::markDirty(int16_t x, int16_t y, int16_t width, int16_t height) {
+	uint8_t col0, col1, page0, page1;
+
+	if (x < 0) {
+		width += x;
+		x = 0;
+	}
+	if (y < 0) {
+		height += y;
+		y = 0;
+	}
+	if (width > LCDWIDTH - x) width = LCDWIDTH - x;
+	if (height > LCDHEIGHT - y) height = LCDHEIGHT - y;
+	if ((width <= 0) || (height <= 0))
+	return;
+
+	col0 = x;
+	col1 = x + width - 1;
+	page0 = y / 8;
+	page1 = (y + height - 1) / 8;
+	if (dirtyCol0 >= LCDWIDTH) {	// region was empty
+		dirtyCol0 = col0;
+		dirtyCol1 = col1;
+		dirtyPage0 = page0;
+		dirtyPage1 = page1;
+		return;
+	}
+	if (col0 < dirtyCol0) dirtyCol0 = col0;
+	if (col1 > dirtyCol1) dirtyCol1 = col1;
+	if (page0 < dirtyPage0) dirtyPage0 = page0;
+	if (page1 > dirtyPage1) dirtyPage1 = page1;
+}
+
+#ifndef MICROOLED_PAGEMODE
+/** \brief Transfer changed display memory.
+
+    Move only the dirty region collected by markDirty() to the SSD1306 controller's memory, then mark everything clean. Nothing is sent if no area was marked.
+*/
+void MicroOLED::displayDirty(void) {
+	if (dirtyCol0 >= LCDWIDTH)
+	return;
+
+	flushWindow(dirtyCol0, dirtyCol1, dirtyPage0, dirtyPage1);
+	dirtyCol0 = LCDWIDTH;
+}
+
+/** \brief Transfer a window of display memory.
+
+    Send columns col0 to col1 of pages page0 to page1 of the screen buffer into the matching controller window, all under a single CS assertion.
+*/
+void MicroOLED::flushWindow(uint8_t col0, uint8_t col1, uint8_t page0, uint8_t page1) {
+	uint8_t width = col1 - col0 + 1;
+	uint16_t bytes = width * (page1 - page0 + 1);
+
+	STAT_FLUSH_BEGIN();
+	setWindow(LCDCOLUMNOFFSET + col0, LCDCOLUMNOFFSET + col1, page0, page1);
+	if (width == LCDWIDTH) {
+		data(screenmemory + page0 * LCDWIDTH, bytes);	// pages are contiguous in the screen buffer
+	}
+	else {
+		dcPin = 1;
+		csPin = 0;
+		for (uint8_t page = page0; page <= page1; page++) {
+			miol_spi.write((const char *)(screenmemory + col0 + page * LCDWIDTH), width, NULL, 0);
+		}
+		csPin = 1;
+		advanceWindow(bytes);
+		STAT_ADD(csAssertions, 1);
+		STAT_ADD(bytesSent, bytes);
+	}
+	STAT_FLUSH_END(bytes);
+}
+#endif
+
+/** \brief Render and transfer page by page.
+
+    Render the screen one page (8 pixel rows) at a time: clear the page, call draw with the clip rectangle reset to that strip, and send the strip to the controller unless its hash shows the controller already holds it (see display()). draw is called once per page and must redraw the whole screen each time, setting the cursor and any clip rectangles itself; every drawing function clips to the strip, and shapes entirely outside it are rejected before any work is done (use isVisible() to skip groups of drawing calls). Built with MICROOLED_PAGEMODE the screen buffer is a single page, so rendering needs LCDWIDTH bytes of RAM instead of a full frame, at the cost of running draw once per page; without it the pages are rendered in place and the screen buffer holds the finished frame afterwards.
+*/
+void MicroOLED::drawPages(Callback<void()> draw) {
+	uint16_t bytes = 0;
+
+	STAT_FLUSH_BEGIN();
+	for (uint8_t page = 0; page < LCDHEIGHT / 8; page++) {
+#ifdef MICROOLED_PAGEMODE
+		uint8_t *strip = screenmemory;
+		bufferPage0 = page;
+#else
+		uint8_t *strip = screenmemory + page * LCDWIDTH;
+#endif
+		uint32_t hash;
+
+		memset(strip, 0, LCDWIDTH);
+		stripY0 = page * 8;
+		stripY1 = stripY0 + 8;
+		resetClip();
+		draw();
+
+		hash = pageHash(strip);
+		if (!(shadowPagesValid & (1 << page)) || (shadowPageHash[page] != hash)) {
+			setWindow(LCDCOLUMNOFFSET, LCDCOLUMNOFFSET + LCDWIDTH - 1, page, page);
+			data(strip, LCDWIDTH);
+			bytes += LCDWIDTH;
+		}
+		shadowPageHash[page] = hash;
+		shadowPagesValid |= 1 << page;
+	}
+	STAT_FLUSH_END(bytes);
+
+	bufferPage0 = 0;
+	resetStrip();
+	resetClip();
+	dirtyCol0 = LCDWIDTH;	// the controller shows what was rendered
+}
+
+/** \brief Reset strip.
+
+    Let drawing functions cover the whole screen buffer, outside drawPages(). In page mode there is no full frame to draw to, so everything is clipped away.
+*/
+void MicroOLED::resetStrip(void) {
+	stripY0 = 0;
+#ifdef MICROOLED_PAGEMODE
+	stripY1 = 0;
+#else
+	stripY1 = LCDHEIGHT;
+#endif
+}
+
+/** \brief Fill SSD1306's memory.
+
+    Write c to the whole controller memory, including the columns and pages outside the visible area, in one bulk transfer.
+*/
+void MicroOLED::fillController(uint8_t c) {
+	uint8_t chunk[LCDTOTALWIDTH];
+
+	memset(chunk, c, sizeof(chunk));
+	setWindow(0, LCDTOTALWIDTH - 1, 0, (LCDTOTALHEIGHT / 8) - 1); // whole controller memory
 	dcPin = 1;
 	csPin = 0;
-	for (int i = 0; i < (LCDWIDTH * LCDHEIGHT / 8); i++) {
-		miol_spi.write(screenmemory[i]);
+	for (int page = 0; page < (LCDTOTALHEIGHT / 8); page++) {
+		miol_spi.write((const char *)chunk, sizeof(chunk), NULL, 0);
 	}
 	csPin = 1;
-	command(MEMORYMODE, 2); // Restore to page addressing mode
+	advanceWindow(LCDTOTALWIDTH * LCDTOTALHEIGHT / 8);
+	STAT_ADD(csAssertions, 1);
+	STAT_ADD(bytesSent, LCDTOTALWIDTH * LCDTOTALHEIGHT / 8);
+}
+
+#ifdef MICROOLED_STATS
+/** \brief Get instrumentation counters.
+
+    Return the counters collected since init() or the last resetStats(). Only available when the library is built with MICROOLED_STATS defined.
+*/
+const MicroOLEDStats &MicroOLED::getStats(void) {
+	return stats;
+}
+
+/** \brief Reset instrumentation counters.
+*/
+void MicroOLED::resetStats(void) {
+	memset(&stats, 0, sizeof(stats));
+}
+
+void MicroOLED::statsFlushBegin(void) {
+	statsTimer.reset();
+	statsTimer.start();
+}
+
+void MicroOLED::statsFlushEnd(uint16_t bytes) {
+	uint32_t us = statsTimer.elapsed_time().count();
+
+	statsTimer.stop();
+	stats.flushes++;
+	stats.flushBytes += bytes;
+	stats.lastFlushUs = us;
+	stats.totalFlushUs += us;
+	if (us > stats.maxFlushUs)
+	stats.maxFlushUs = us;
+}
+#endif
+
+/** \brief Set controller address window.
+
+    Set the column and page bounds that following data bytes are written to. The controller stays in horizontal addressing mode, so its address pointer wraps back to the window origin once the whole window has been written; if the requested window is already set and the pointer is at its origin no command is sent at all.
+*/
+void MicroOLED::setWindow(uint8_t col0, uint8_t col1, uint8_t page0, uint8_t page1) {
+	if (windowValid && (windowOffset == 0) && (col0 == windowCol0) && (col1 == windowCol1) && (page0 == windowPage0) && (page1 == windowPage1))
+	return;
+
+	const uint8_t cmds[] = { SETCOLUMNBOUNDS, col0, col1, SETPAGEBOUNDS, page0, page1 };
+	command(cmds, sizeof(cmds));
+
+	windowCol0 = col0;
+	windowCol1 = col1;
+	windowPage0 = page0;
+	windowPage1 = page1;
+	windowOffset = 0;
+	windowValid = true;
+}
+
+/** \brief Track controller address pointer.
+
+    Account for bytes written into the current address window so that setWindow() knows whether the pointer has wrapped back to the window origin, and forget the page hashes of the pages in the window.
+*/
+void MicroOLED::advanceWindow(uint16_t bytes) {
+	uint16_t size = (windowCol1 - windowCol0 + 1) * (windowPage1 - windowPage0 + 1);
+	windowOffset = (windowOffset + bytes) % size;
+	shadowPagesValid &= ~(((1 << (windowPage1 + 1)) - 1) & ~((1 << windowPage0) - 1));	// display() re-records what it sent
 }
 
 /*
@@ -277,7 +771,7 @@ void MicroOLED::putc(char c) {
 	} else {
 		drawChar(cursorX, cursorY, (uint8_t)c, foreColor, drawMode);
 		cursorX += fontWidth+1;
-		if ((cursorX > (LCDWIDTH - fontWidth))) {
+		if ((cursorX > (getLCDWidth() - fontWidth))) {
 			cursorY += fontHeight;
 			cursorX = 0;
 		}
@@ -315,48 +809,150 @@ void MicroOLED::setCursor(uint8_t x, uint8_t y) {
 	cursorY=y;
 }
 
+// Pixel operations, one per color and draw mode combination. Drawing loops are
+// instantiated once per operation so the color/mode test runs once per primitive.
+struct OpSet {
+	void operator()(uint8_t &b, uint8_t mask) const { b |= mask; }
+};
+struct OpClear {
+	void operator()(uint8_t &b, uint8_t mask) const { b &= ~mask; }
+};
+struct OpInvert {
+	void operator()(uint8_t &b, uint8_t mask) const { b ^= mask; }
+};
+
+/** \brief Select pixel operation.
+
+    Call kernel with the pixel operation for color and mode. XOR with BLACK changes nothing, so kernel is not called at all.
+*/
+template<class Kernel>
+static inline void withOp(uint8_t color, uint8_t mode, Kernel kernel) {
+	if (mode==XOR) {
+		if (color==WHITE)
+		kernel(OpInvert());
+	}
+	else {
+		if (color==WHITE)
+		kernel(OpSet());
+		else
+		kernel(OpClear());
+	}
+}
+
+/** \brief Draw pixel without clipping.
+
+Same as pixel() for callers that have already clipped their shape against the screen.
+*/
+template<class Op>
+static inline void plot(Op op, uint8_t x, uint8_t y) {
+	op(screenmemory[bufferIndex(x, y >> 3)], 1 << (y & 7));
+}
+
+/** \brief Fill vertical span.
+
+    Apply op to pixels y0 to y1 of column x in the screen buffer, one page byte at a time using page masks. Coordinates must already be clipped to the screen.
+*/
+template<class Op>
+static inline void spanV(Op op, uint8_t x, uint8_t y0, uint8_t y1) {
+	uint8_t *p = screenmemory + bufferIndex(x, y0 >> 3);
+	uint8_t *last = screenmemory + bufferIndex(x, y1 >> 3);
+	uint8_t mask = 0xFF << (y0 & 7);
+
+	for (; p < last; p += LCDWIDTH) {
+		op(*p, mask);
+		mask = 0xFF;
+	}
+	op(*p, mask & (0xFF >> (7 - (y1 & 7))));
+}
+
+/** \brief Apply operation to a column of 8 pixels.
+
+    Apply op to the pixels of column x, rows y to y+7, whose bit is set in bits (bit 0 is row y), skipping rows outside top to bottom - 1. The 8 rows may straddle two pages. top and bottom must lie on the screen.
+*/
+template<class Op>
+static inline void column8(Op op, uint8_t x, int16_t y, uint8_t bits, int16_t top, int16_t bottom) {
+	if ((y + 8 <= top) || (y >= bottom))
+	return;
+	if (y < top) bits &= 0xFF << (top - y);
+	if (y + 8 > bottom) bits &= 0xFF >> (y + 8 - bottom);
+	if (bits == 0)
+	return;
+
+	uint16_t window = (uint16_t)bits << (y & 7);
+	int16_t page = y >> 3;		// floor, y may be negative
+
+	if (window & 0xFF)
+	op(screenmemory[bufferIndex(x, page)], window & 0xFF);
+	if (window >> 8)
+	op(screenmemory[bufferIndex(x, page + 1)], window >> 8);
+}
+
 /** \brief Draw pixel.
 
 Draw pixel using the current fore color and current draw mode in the screen buffer's x,y position.
 */
-void MicroOLED::pixel(uint8_t x, uint8_t y) {
+void MicroOLED::pixel(int16_t x, int16_t y) {
 	pixel(x,y,foreColor,drawMode);
 }
 
 /** \brief Draw pixel with color and mode.
 
-Draw color pixel in the screen buffer's x,y position with NORM or XOR draw mode.
+Draw color pixel in the screen buffer's x,y position with NORM or XOR draw mode. Pixels outside the clip rectangle are ignored.
 */
-void MicroOLED::pixel(uint8_t x, uint8_t y, uint8_t color, uint8_t mode) {
-	if ((x>=LCDWIDTH) || (y>=LCDHEIGHT))
+void MicroOLED::pixel(int16_t x, int16_t y, uint8_t color, uint8_t mode) {
+	x += originX;
+	y += originY;
+	toPanel(x, y);
+	clippedPlot(x, y, color, mode);
+}
+
+/** \brief Draw pixel in screen coordinates.
+
+Draw pixel at panel position x,y (no viewport translation or rotation) if it lies inside the clip rectangle. Used by shapes that can only be clipped point by point.
+*/
+void MicroOLED::clippedPlot(int16_t x, int16_t y, uint8_t color, uint8_t mode) {
+	if ((x<clipX0) || (y<clipY0) || (x>=clipX1) || (y>=clipY1))
 	return;
 	
-	if (mode==XOR) {
-		if (color==WHITE)
-		screenmemory[x+ (y/8)*LCDWIDTH] ^= _BV((y%8));
-	}
-	else {
-		if (color==WHITE)
-		screenmemory[x+ (y/8)*LCDWIDTH] |= _BV((y%8));
-		else
-		screenmemory[x+ (y/8)*LCDWIDTH] &= ~_BV((y%8)); 
-	}
+	STAT_ADD(pixels, 1);
+	withOp(color, mode, [&](auto op) {
+		plot(op, x, y);
+	});
 }
 
 /** \brief Draw line.
 
 Draw line using current fore color and current draw mode from x0,y0 to x1,y1 of the screen buffer.
 */
-void MicroOLED::line(uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1) {
+void MicroOLED::line(int16_t x0, int16_t y0, int16_t x1, int16_t y1) {
 	line(x0,y0,x1,y1,foreColor,drawMode);
 }
 
+/** \brief Integer floor division (den > 0).
+*/
+static inline int32_t floorDiv(int64_t num, int32_t den) {
+	int32_t q = num / den;
+
+	if ((q * (int64_t)den) > num)
+	q--;
+	return q;
+}
+
 /** \brief Draw line with color and mode.
 
-Draw line using color and mode from x0,y0 to x1,y1 of the screen buffer.
+Draw line using color and mode from x0,y0 to x1,y1 of the screen buffer. The end point itself is not drawn.
+
+The line is clipped once, Liang-Barsky style, in Bresenham step space: the first and last visible steps along the major axis are computed directly from the clip rectangle, and the error term is set up for the first visible step. Only visible pixels are walked, they match the pixels of the unclipped line exactly, and no pixel needs a bounds check.
 */
-void MicroOLED::line(uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1, uint8_t color, uint8_t mode) {
-	uint8_t steep = abs(y1 - y0) > abs(x1 - x0);
+void MicroOLED::line(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint8_t color, uint8_t mode) {
+	x0 += originX;
+	y0 += originY;
+	x1 += originX;
+	y1 += originY;
+	toPanel(x0, y0);
+	toPanel(x1, y1);
+
+	bool steep = abs(y1 - y0) > abs(x1 - x0);
 	if (steep) {
 		swap(x0, y0);
 		swap(x1, y1);
@@ -367,69 +963,143 @@ void MicroOLED::line(uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1, uint8_t col
 		swap(y0, y1);
 	}
 
-	uint8_t dx, dy;
-	dx = x1 - x0;
-	dy = abs(y1 - y0);
-
-	int8_t err = dx / 2;
-	int8_t ystep;
-
-	if (y0 < y1) {
-		ystep = 1;
-	} else {
-		ystep = -1;}
+	int32_t dx = x1 - x0;
+	int32_t dy = abs(y1 - y0);
+	int32_t half = dx / 2;
+	int8_t ystep = (y0 < y1) ? 1 : -1;
+	int16_t major0 = steep ? clipY0 : clipX0, major1 = steep ? clipY1 : clipX1;
+	int16_t minor0 = steep ? clipX0 : clipY0, minor1 = steep ? clipX1 : clipY1;
+
+	// step k (0 <= k < dx) draws major coordinate x0 + k, minor coordinate y0 + ystep * j(k),
+	// j(k) = max(0, ceil((k * dy - half) / dx)) minor steps taken so far
+	int32_t kFirst = (x0 < major0) ? major0 - x0 : 0;
+	int32_t kLast = dx - 1;
+	if (kLast > major1 - 1 - x0) kLast = major1 - 1 - x0;
+
+	// minor steps that keep the minor coordinate inside the clip rectangle
+	int32_t jFirst = (ystep > 0) ? minor0 - y0 : y0 - (minor1 - 1);
+	int32_t jLast = (ystep > 0) ? (minor1 - 1) - y0 : y0 - minor0;
+	if (jLast < 0)
+	return;
+	if (dy == 0) {
+		if (jFirst > 0)
+		return;
+	}
+	else {
+		if (jFirst > 0) {
+			int32_t k = floorDiv((int64_t)(jFirst - 1) * dx + half, dy) + 1;
+			if (k > kFirst) kFirst = k;
+		}
+		int32_t k = floorDiv((int64_t)jLast * dx + half, dy);
+		if (k < kLast) kLast = k;
+	}
+	if (kFirst > kLast)
+	return;
 
-	for (; x0<x1; x0++) {
-		if (steep) {
-			pixel(y0, x0, color, mode);
-		} else {
-			pixel(x0, y0, color, mode);
+	// Bresenham state at the first visible step
+	int32_t j = (kFirst * (int64_t)dy > half) ? floorDiv(kFirst * (int64_t)dy - half + dx - 1, dx) : 0;
+	int32_t err = half - kFirst * dy + j * dx;
+	int16_t x = x0 + kFirst;
+	int16_t y = y0 + ystep * j;
+	int32_t count = kLast - kFirst + 1;
+
+	STAT_ADD(primitives, 1);
+	STAT_ADD(pixels, count);
+	withOp(color, mode, [&](auto op) {
+		// walk a byte index and bit mask instead of recomputing y/8 and y%8 per pixel
+		if (steep) {	// major axis is screen y, minor axis is screen x
+			int16_t p = bufferIndex(y, x >> 3);
+			uint8_t bit = 1 << (x & 7);
+			for (int32_t k = 0; k < count; k++) {
+				op(screenmemory[p], bit);
+				bit <<= 1;
+				if (bit == 0) {
+					bit = 0x01;
+					p += LCDWIDTH;
+				}
+				err -= dy;
+				if (err < 0) {
+					p += ystep;
+					err += dx;
+				}
+			}
 		}
-		err -= dy;
-		if (err < 0) {
-			y0 += ystep;
-			err += dx;
+		else {
+			int16_t p = bufferIndex(x, y >> 3);
+			uint8_t bit = 1 << (y & 7);
+			for (int32_t k = 0; k < count; k++) {
+				op(screenmemory[p], bit);
+				p++;
+				err -= dy;
+				if (err < 0) {
+					err += dx;
+					if (ystep > 0) {
+						bit <<= 1;
+						if (bit == 0) {
+							bit = 0x01;
+							p += LCDWIDTH;
+						}
+					}
+					else {
+						bit >>= 1;
+						if (bit == 0) {
+							bit = 0x80;
+							p -= LCDWIDTH;
+						}
+					}
+				}
+			}
 		}
-	}	
+	});
 }
 
 /** \brief Draw horizontal line.
 
 Draw horizontal line using current fore color and current draw mode from x,y to x+width,y of the screen buffer.
 */
-void MicroOLED::lineH(uint8_t x, uint8_t y, uint8_t width) {
-	line(x,y,x+width,y,foreColor,drawMode);
+void MicroOLED::lineH(int16_t x, int16_t y, uint8_t width) {
+	lineH(x,y,width,foreColor,drawMode);
 }
 
 /** \brief Draw horizontal line with color and mode.
 
 Draw horizontal line using color and mode from x,y to x+width,y of the screen buffer.
 */
-void MicroOLED::lineH(uint8_t x, uint8_t y, uint8_t width, uint8_t color, uint8_t mode) {
-	line(x,y,x+width,y,color,mode);
+void MicroOLED::lineH(int16_t x, int16_t y, uint8_t width, uint8_t color, uint8_t mode) {
+	int16_t w = width, h = 1;
+
+	x += originX;
+	y += originY;
+	toPanel(x, y, w, h);
+	fillRect(x, y, w, h, color, mode);
 }
 
 /** \brief Draw vertical line.
 
 Draw vertical line using current fore color and current draw mode from x,y to x,y+height of the screen buffer.
 */
-void MicroOLED::lineV(uint8_t x, uint8_t y, uint8_t height) {
-	line(x,y,x,y+height,foreColor,drawMode);
+void MicroOLED::lineV(int16_t x, int16_t y, uint8_t height) {
+	lineV(x,y,height,foreColor,drawMode);
 }
 
 /** \brief Draw vertical line with color and mode.
 
 Draw vertical line using color and mode from x,y to x,y+height of the screen buffer.
 */
-void MicroOLED::lineV(uint8_t x, uint8_t y, uint8_t height, uint8_t color, uint8_t mode) {
-	line(x,y,x,y+height,color,mode);
+void MicroOLED::lineV(int16_t x, int16_t y, uint8_t height, uint8_t color, uint8_t mode) {
+	int16_t w = 1, h = height;
+
+	x += originX;
+	y += originY;
+	toPanel(x, y, w, h);
+	fillRect(x, y, w, h, color, mode);
 }
 
 /** \brief Draw rectangle.
 
 Draw rectangle using current fore color and current draw mode from x,y to x+width,y+height of the screen buffer.
 */
-void MicroOLED::rect(uint8_t x, uint8_t y, uint8_t width, uint8_t height) {
+void MicroOLED::rect(int16_t x, int16_t y, uint8_t width, uint8_t height) {
 	rect(x,y,width,height,foreColor,drawMode);
 }
 
@@ -437,19 +1107,24 @@ void MicroOLED::rect(uint8_t x, uint8_t y, uint8_t width, uint8_t height) {
 
 Draw rectangle using color and mode from x,y to x+width,y+height of the screen buffer.
 */
-void MicroOLED::rect(uint8_t x, uint8_t y, uint8_t width, uint8_t height, uint8_t color , uint8_t mode) {
+void MicroOLED::rect(int16_t x, int16_t y, uint8_t width, uint8_t height, uint8_t color , uint8_t mode) {
 	uint8_t tempHeight;
 	
+	if ((width==0) || (height==0))
+	return;
+
 	lineH(x,y, width, color, mode);
+	if (height>1)
 	lineH(x,y+height-1, width, color, mode);
 	
 	tempHeight=height-2;
 	
 	// skip drawing vertical lines to avoid overlapping of pixel that will 
 	// affect XOR plot if no pixel in between horizontal lines		
-	if (tempHeight<1) return;			
+	if ((height<3) || (tempHeight<1)) return;
 
 	lineV(x,y+1, tempHeight, color, mode);
+	if (width>1)
 	lineV(x+width-1, y+1, tempHeight, color, mode);
 }
 
@@ -457,7 +1132,7 @@ void MicroOLED::rect(uint8_t x, uint8_t y, uint8_t width, uint8_t height, uint8_
 
 Draw filled rectangle using current fore color and current draw mode from x,y to x+width,y+height of the screen buffer.
 */
-void MicroOLED::rectFill(uint8_t x, uint8_t y, uint8_t width, uint8_t height) {
+void MicroOLED::rectFill(int16_t x, int16_t y, uint8_t width, uint8_t height) {
 	rectFill(x,y,width,height,foreColor,drawMode);
 }
 
@@ -465,37 +1140,78 @@ void MicroOLED::rectFill(uint8_t x, uint8_t y, uint8_t width, uint8_t height) {
 
 Draw filled rectangle using color and mode from x,y to x+width,y+height of the screen buffer.
 */	
-void MicroOLED::rectFill(uint8_t x, uint8_t y, uint8_t width, uint8_t height, uint8_t color , uint8_t mode) {
-	// TODO - need to optimise the memory map draw so that this function will not call pixel one by one
-	for (int i=x; i<x+width;i++) {
-		lineV(i,y, height, color, mode);
-	}
+void MicroOLED::rectFill(int16_t x, int16_t y, uint8_t width, uint8_t height, uint8_t color , uint8_t mode) {
+	int16_t w = width, h = height;
+
+	x += originX;
+	y += originY;
+	toPanel(x, y, w, h);
+	fillRect(x, y, w, h, color, mode);
+}
+
+/** \brief Fill panel rectangle.
+
+    Fill the width x height rectangle at panel position x,y with color and mode. Clipped once against the clip rectangle, then a single row shares one page and bit mask, and taller rectangles are filled a column span at a time with page masks.
+*/
+void MicroOLED::fillRect(int16_t x, int16_t y, int16_t width, int16_t height, uint8_t color, uint8_t mode) {
+	int16_t x1 = x + width, y1 = y + height;	// exclusive
+
+	if (x < clipX0) x = clipX0;
+	if (y < clipY0) y = clipY0;
+	if (x1 > clipX1) x1 = clipX1;
+	if (y1 > clipY1) y1 = clipY1;
+	if ((x >= x1) || (y >= y1))
+	return;
+
+	STAT_ADD(primitives, 1);
+	STAT_ADD(pixels, (x1 - x) * (y1 - y));
+	withOp(color, mode, [&](auto op) {
+		if (y1 - y == 1) {
+			uint8_t *p = screenmemory + bufferIndex(x, y >> 3);
+			uint8_t *end = p + (x1 - x);
+			uint8_t bit = 1 << (y & 7);
+
+			for (; p < end; p++) op(*p, bit);
+		}
+		else {
+			for (int16_t i=x; i<x1; i++) {
+				spanV(op, i, y, y1-1);
+			}
+		}
+	});
 }
 
 /** \brief Draw circle.
 
     Draw circle with radius using current fore color and current draw mode at x,y of the screen buffer.
 */
-void MicroOLED::circle(uint8_t x0, uint8_t y0, uint8_t radius) {
+void MicroOLED::circle(int16_t x0, int16_t y0, uint8_t radius) {
 	circle(x0,y0,radius,foreColor,drawMode);
 }
 
-/** \brief Draw circle with color and mode.
+/** \brief Plot circle outline.
 
-Draw circle with radius using color and mode at x,y of the screen buffer.
+    Midpoint circle outline of radius around x0,y0, with op applied to each point. With CLIP, points outside cx0,cy0 to cx1-1,cy1-1 are skipped, otherwise the whole circle must lie on the screen.
 */
-void MicroOLED::circle(uint8_t x0, uint8_t y0, uint8_t radius, uint8_t color, uint8_t mode) {
+template<bool CLIP, class Op>
+static void circlePoints(Op op, int16_t x0, int16_t y0, uint8_t radius, int16_t cx0, int16_t cy0, int16_t cx1, int16_t cy1) {
 	//TODO - find a way to check for no overlapping of pixels so that XOR draw mode will work perfectly 
-	int8_t f = 1 - radius;
-	int8_t ddF_x = 1;
-	int8_t ddF_y = -2 * radius;
-	int8_t x = 0;
-	int8_t y = radius;
+	int16_t f = 1 - radius;
+	int16_t ddF_x = 1;
+	int16_t ddF_y = -2 * radius;
+	int16_t x = 0;
+	int16_t y = radius;
+
+	auto put = [&](int16_t px, int16_t py) {
+		if (CLIP && ((px<cx0) || (py<cy0) || (px>=cx1) || (py>=cy1)))
+		return;
+		plot(op, px, py);
+	};
 
-	pixel(x0, y0+radius, color, mode);
-	pixel(x0, y0-radius, color, mode);
-	pixel(x0+radius, y0, color, mode);
-	pixel(x0-radius, y0, color, mode);
+	put(x0, y0+radius);
+	put(x0, y0-radius);
+	put(x0+radius, y0);
+	put(x0-radius, y0);
 
 	while (x<y) {
 		if (f >= 0) {
@@ -507,46 +1223,69 @@ void MicroOLED::circle(uint8_t x0, uint8_t y0, uint8_t radius, uint8_t color, ui
 		ddF_x += 2;
 		f += ddF_x;
 
-		pixel(x0 + x, y0 + y, color, mode);
-		pixel(x0 - x, y0 + y, color, mode);
-		pixel(x0 + x, y0 - y, color, mode);
-		pixel(x0 - x, y0 - y, color, mode);
-		
-		pixel(x0 + y, y0 + x, color, mode);
-		pixel(x0 - y, y0 + x, color, mode);
-		pixel(x0 + y, y0 - x, color, mode);
-		pixel(x0 - y, y0 - x, color, mode);
+		put(x0 + x, y0 + y);
+		put(x0 - x, y0 + y);
+		put(x0 + x, y0 - y);
+		put(x0 - x, y0 - y);
 		
+		put(x0 + y, y0 + x);
+		put(x0 - y, y0 + x);
+		put(x0 + y, y0 - x);
+		put(x0 - y, y0 - x);
 	}
 }
 
+/** \brief Draw circle with color and mode.
+
+Draw circle with radius using color and mode at x,y of the screen buffer. A circle entirely outside the clip rectangle is rejected up front, one entirely inside is drawn without any bounds checks.
+*/
+void MicroOLED::circle(int16_t x0, int16_t y0, uint8_t radius, uint8_t color, uint8_t mode) {
+	x0 += originX;
+	y0 += originY;
+	toPanel(x0, y0);
+	if ((x0 + radius < clipX0) || (y0 + radius < clipY0) || (x0 - radius >= clipX1) || (y0 - radius >= clipY1))
+	return;
+
+	STAT_ADD(primitives, 1);
+	withOp(color, mode, [&](auto op) {
+		if ((x0 - radius < clipX0) || (y0 - radius < clipY0) || (x0 + radius >= clipX1) || (y0 + radius >= clipY1)) {
+			// partly visible, clip point by point
+			circlePoints<true>(op, x0, y0, radius, clipX0, clipY0, clipX1, clipY1);
+		}
+		else {
+			circlePoints<false>(op, x0, y0, radius, clipX0, clipY0, clipX1, clipY1);
+			STAT_ADD(pixels, 8 * radius);
+		}
+	});
+}
+
 /** \brief Draw filled circle.
 
     Draw filled circle with radius using current fore color and current draw mode at x,y of the screen buffer.
 */
-void MicroOLED::circleFill(uint8_t x0, uint8_t y0, uint8_t radius) {
+void MicroOLED::circleFill(int16_t x0, int16_t y0, uint8_t radius) {
 	circleFill(x0,y0,radius,foreColor,drawMode);
 }
 
 /** \brief Draw filled circle with color and mode.
 
-    Draw filled circle with radius using color and mode at x,y of the screen buffer.
+    Draw filled circle with radius using color and mode at x,y of the screen buffer. The midpoint algorithm first collects the half height of every column, then each visible column is drawn once as a clipped vertical span, so XOR mode works and nothing is checked per pixel.
 */
-void MicroOLED::circleFill(uint8_t x0, uint8_t y0, uint8_t radius, uint8_t color, uint8_t mode) {
-	// TODO - - find a way to check for no overlapping of pixels so that XOR draw mode will work perfectly 
-	int8_t f = 1 - radius;
-	int8_t ddF_x = 1;
-	int8_t ddF_y = -2 * radius;
-	int8_t x = 0;
-	int8_t y = radius;
-
-	// Temporary disable fill circle for XOR mode.
-	if (mode==XOR) return;
-	
-	for (uint8_t i=y0-radius; i<=y0+radius; i++) {
-		pixel(x0, i, color, mode);
-	}
+void MicroOLED::circleFill(int16_t x0, int16_t y0, uint8_t radius, uint8_t color, uint8_t mode) {
+	int16_t f = 1 - radius;
+	int16_t ddF_x = 1;
+	int16_t ddF_y = -2 * radius;
+	int16_t x = 0;
+	int16_t y = radius;
+	uint8_t halfHeight[256];	// half height of column x0 +/- i
+
+	x0 += originX;
+	y0 += originY;
+	toPanel(x0, y0);
+	if ((x0 + radius < clipX0) || (y0 + radius < clipY0) || (x0 - radius >= clipX1) || (y0 - radius >= clipY1))
+	return;
 
+	halfHeight[0] = radius;
 	while (x<y) {
 		if (f >= 0) {
 			y--;
@@ -557,14 +1296,375 @@ void MicroOLED::circleFill(uint8_t x0, uint8_t y0, uint8_t radius, uint8_t color
 		ddF_x += 2;
 		f += ddF_x;
 
-		for (uint8_t i=y0-y; i<=y0+y; i++) {
-			pixel(x0+x, i, color, mode);
-			pixel(x0-x, i, color, mode);
-		} 
-		for (uint8_t i=y0-x; i<=y0+x; i++) {
-			pixel(x0+y, i, color, mode);
-			pixel(x0-y, i, color, mode);
-		}    
+		halfHeight[x] = y;	// first time column x is reached has the largest y
+		halfHeight[y] = x;	// last time column y is reached has the largest x
+	}
+
+	STAT_ADD(primitives, 1);
+	withOp(color, mode, [&](auto op) {
+		for (int16_t i = -radius; i <= radius; i++) {
+			int16_t col = x0 + i;
+			if ((col < clipX0) || (col >= clipX1))
+			continue;
+
+			uint8_t h = halfHeight[abs(i)];
+			int16_t top = y0 - h, bottom = y0 + h;
+			if (top < clipY0) top = clipY0;
+			if (bottom >= clipY1) bottom = clipY1 - 1;
+			if (top > bottom)
+			continue;
+
+			spanV(op, col, top, bottom);
+			STAT_ADD(pixels, bottom - top + 1);
+		}
+	});
+}
+
+/** \brief Draw filled polygon.
+
+    Draw filled polygon with count vertices x[i],y[i] using current fore color and current draw mode. rule is FILL_EVENODD or FILL_NONZERO.
+*/
+void MicroOLED::polygonFill(const int16_t *x, const int16_t *y, uint8_t count, uint8_t rule) {
+	polygonFill(x,y,count,rule,foreColor,drawMode);
+}
+
+/** \brief Integer floor division and modulo.
+
+    Split num/den (den > 0) into quotient rounded towards minus infinity and a remainder in [0, den).
+*/
+static inline void floorDivMod(int64_t num, int32_t den, int32_t &q, int32_t &r) {
+	q = num / den;
+	r = num - (int64_t)q * den;
+	if (r < 0) {
+		q--;
+		r += den;
+	}
+}
+
+/** \brief Draw filled polygon with color and mode.
+
+    Draw filled polygon with count vertices (the polygon is closed automatically) using color and mode. Nothing is drawn for fewer than 3 or more than MAXPOLYGONVERTICES vertices. rule selects which enclosed areas are filled: FILL_EVENODD or FILL_NONZERO. Vertices may lie off the screen.
+
+    The polygon is scanned column by column, since columns map to vertical bytes in the screen buffer. An edge table sorted by starting column feeds an active edge list; each active edge steps its crossing row with an exact integer DDA (quotient and remainder), and the spans between crossings go to the page-mask span kernel. Every pixel is written at most once, so XOR mode works.
+*/
+void MicroOLED::polygonFill(const int16_t *x, const int16_t *y, uint8_t count, uint8_t rule, uint8_t color, uint8_t mode) {
+	struct Edge {
+		int16_t xStart, xEnd;	// columns c with xStart <= c < xEnd are crossed (at c + 0.5)
+		int16_t y0;
+		int32_t q, r, den;		// crossing row = y0 + q + r/den
+		int32_t stepQ, stepR;	// added per column
+		int8_t dir;				// +1 if the edge runs left to right, -1 otherwise
+	};
+	Edge edges[MAXPOLYGONVERTICES];
+	uint8_t order[MAXPOLYGONVERTICES], active[MAXPOLYGONVERTICES];
+	int16_t rows[MAXPOLYGONVERTICES];
+	int8_t dirs[MAXPOLYGONVERTICES];
+	uint8_t edgeCount = 0, activeCount = 0, nextEdge = 0;
+	uint8_t i, j, k, n;
+	int16_t col, colEnd;
+
+	if ((count < 3) || (count > MAXPOLYGONVERTICES))
+	return;
+
+	// vertices in panel coordinates, and their bounding box to reject polygons outside the clip rectangle
+	int16_t px[MAXPOLYGONVERTICES], py[MAXPOLYGONVERTICES];
+	int16_t minX = INT16_MAX, minY = INT16_MAX, maxX = INT16_MIN, maxY = INT16_MIN;
+	for (i = 0; i < count; i++) {
+		int16_t w = 0, h = 0;
+		px[i] = x[i] + originX;
+		py[i] = y[i] + originY;
+		toPanel(px[i], py[i], w, h);	// vertices are pixel corners: map them as an empty rectangle, not as a pixel
+		if (px[i] < minX) minX = px[i];
+		if (px[i] > maxX) maxX = px[i];
+		if (py[i] < minY) minY = py[i];
+		if (py[i] > maxY) maxY = py[i];
+	}
+	if ((maxX < clipX0) || (maxY < clipY0) || (minX >= clipX1) || (minY >= clipY1))
+	return;
+
+	// edge table, horizontal edges never cross a column centre and are dropped
+	for (i = 0; i < count; i++) {
+		j = (i + 1) % count;
+		if (px[i] == px[j])
+		continue;
+
+		Edge &e = edges[edgeCount];
+		int16_t ax = px[i], ay = py[i], bx = px[j], by = py[j];
+		e.dir = 1;
+		if (ax > bx) {
+			int16_t t;
+			t = ax; ax = bx; bx = t;
+			t = ay; ay = by; by = t;
+			e.dir = -1;
+		}
+		// y at column centre c + 0.5 is ay + (2c + 1 - 2ax) * dy / (2dx)
+		int32_t dy = by - ay;
+		e.xStart = ax;
+		e.xEnd = bx;
+		e.y0 = ay;
+		e.den = 2 * ((int32_t)bx - ax);
+		floorDivMod(dy, e.den, e.q, e.r);
+		floorDivMod(2 * dy, e.den, e.stepQ, e.stepR);
+		if (e.xStart < clipX0) {	// start at the first visible column
+			floorDivMod(dy + 2 * (int64_t)dy * (clipX0 - e.xStart), e.den, e.q, e.r);
+			e.xStart = clipX0;
+		}
+		if (e.xStart >= e.xEnd)
+		continue;
+
+		// keep order[] sorted by starting column
+		for (k = edgeCount; (k > 0) && (edges[order[k - 1]].xStart > e.xStart); k--) {
+			order[k] = order[k - 1];
+		}
+		order[k] = edgeCount++;
+	}
+	if (edgeCount == 0)
+	return;
+
+	STAT_ADD(primitives, 1);
+	col = edges[order[0]].xStart;
+	colEnd = clipX1;
+	withOp(color, mode, [&](auto op) {
+		for (; (col < colEnd) && ((nextEdge < edgeCount) || (activeCount > 0)); col++) {
+			// move edges starting here from the edge table to the active list
+			while ((nextEdge < edgeCount) && (edges[order[nextEdge]].xStart == col)) {
+				active[activeCount++] = order[nextEdge++];
+			}
+
+			// crossing rows of all active edges, insertion sorted
+			n = 0;
+			for (i = 0; i < activeCount; i++) {
+				Edge &e = edges[active[i]];
+				int16_t row = e.y0 + e.q + ((2 * e.r > e.den) ? 1 : 0);	// first row whose centre is below the crossing
+				for (k = n; (k > 0) && (rows[k - 1] > row); k--) {
+					rows[k] = rows[k - 1];
+					dirs[k] = dirs[k - 1];
+				}
+				rows[k] = row;
+				dirs[k] = e.dir;
+				n++;
+			}
+
+			// spans between crossings
+			int8_t winding = 0;
+			for (i = 0; i + 1 < n; i++) {
+				winding += dirs[i];
+				if ((rule == FILL_EVENODD) ? (i % 2 == 0) : (winding != 0)) {
+					int16_t top = rows[i], bottom = rows[i + 1];	// rows top to bottom - 1 are inside
+					if (top < clipY0) top = clipY0;
+					if (bottom > clipY1) bottom = clipY1;
+					if (top < bottom) {
+						spanV(op, col, top, bottom - 1);
+						STAT_ADD(pixels, bottom - top);
+					}
+				}
+			}
+
+			// step active edges to the next column, dropping finished ones
+			for (i = 0, k = 0; i < activeCount; i++) {
+				Edge &e = edges[active[i]];
+				if (col + 1 >= e.xEnd)
+				continue;
+				e.q += e.stepQ;
+				e.r += e.stepR;
+				if (e.r >= e.den) {
+					e.q++;
+					e.r -= e.den;
+				}
+				active[k++] = active[i];
+			}
+			activeCount = k;
+
+			// nothing active: skip ahead to the next edge
+			if ((activeCount == 0) && (nextEdge < edgeCount))
+			col = edges[order[nextEdge]].xStart - 1;
+		}
+	});
+}
+
+/** \brief Draw filled triangle.
+
+    Draw filled triangle with corners x0,y0, x1,y1 and x2,y2 using current fore color and current draw mode.
+*/
+void MicroOLED::triangleFill(int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_t x2, int16_t y2) {
+	triangleFill(x0,y0,x1,y1,x2,y2,foreColor,drawMode);
+}
+
+/** \brief Draw filled triangle with color and mode.
+
+    Draw filled triangle with corners x0,y0, x1,y1 and x2,y2 using color and mode.
+*/
+void MicroOLED::triangleFill(int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_t x2, int16_t y2, uint8_t color, uint8_t mode) {
+	const int16_t x[] = { x0, x1, x2 };
+	const int16_t y[] = { y0, y1, y2 };
+
+	polygonFill(x, y, 3, FILL_EVENODD, color, mode);
+}
+
+/** \brief Push clip rectangle.
+
+    Save the current clip rectangle and viewport, then restrict drawing to the width x height rectangle at x,y (in current drawing coordinates) intersected with the current clip rectangle. Every primitive rejects or trims whole shapes and spans against it. Return false, changing nothing, if MAXCLIPDEPTH states are already saved.
+*/
+boolean MicroOLED::pushClip(int16_t x, int16_t y, uint8_t width, uint8_t height) {
+	if (clipDepth >= MAXCLIPDEPTH)
+	return false;
+
+	ClipState &saved = clipStack[clipDepth++];
+	saved.x0 = clipX0;
+	saved.y0 = clipY0;
+	saved.x1 = clipX1;
+	saved.y1 = clipY1;
+	saved.originX = originX;
+	saved.originY = originY;
+
+	int16_t w = width, h = height;
+	x += originX;
+	y += originY;
+	toPanel(x, y, w, h);
+	if (x > clipX0) clipX0 = x;
+	if (y > clipY0) clipY0 = y;
+	if (x + w < clipX1) clipX1 = x + w;
+	if (y + h < clipY1) clipY1 = y + h;
+	if (clipX1 < clipX0) clipX1 = clipX0;	// empty
+	if (clipY1 < clipY0) clipY1 = clipY0;
+	return true;
+}
+
+/** \brief Push viewport.
+
+    Same as pushClip(), and also move the drawing origin to x,y, so a widget can draw in its own coordinates with 0,0 at the top left corner of its window.
+*/
+boolean MicroOLED::pushViewport(int16_t x, int16_t y, uint8_t width, uint8_t height) {
+	if (!pushClip(x, y, width, height))
+	return false;
+
+	originX += x;
+	originY += y;
+	return true;
+}
+
+/** \brief Pop clip rectangle.
+
+    Restore the clip rectangle and viewport saved by the matching pushClip() or pushViewport().
+*/
+void MicroOLED::popClip(void) {
+	if (clipDepth == 0)
+	return;
+
+	ClipState &saved = clipStack[--clipDepth];
+	clipX0 = saved.x0;
+	clipY0 = saved.y0;
+	clipX1 = saved.x1;
+	clipY1 = saved.y1;
+	originX = saved.originX;
+	originY = saved.originY;
+}
+
+/** \brief Reset clip rectangle.
+
+    Drop all saved states and draw to the whole screen (the current strip inside drawPages()) with the origin at its top left corner.
+*/
+void MicroOLED::resetClip(void) {
+	clipDepth = 0;
+	clipX0 = 0;
+	clipY0 = stripY0;
+	clipX1 = LCDWIDTH;
+	clipY1 = stripY1;
+	originX = 0;
+	originY = 0;
+}
+
+/** \brief Test rectangle visibility.
+
+    True if any part of the width x height rectangle at x,y (drawing coordinates) lies inside the clip rectangle. Inside a drawPages() callback this culls groups of drawing calls that fall outside the current strip.
+*/
+boolean MicroOLED::isVisible(int16_t x, int16_t y, uint8_t width, uint8_t height) {
+	int16_t w = width, h = height;
+
+	x += originX;
+	y += originY;
+	toPanel(x, y, w, h);
+	return (x < clipX1) && (y < clipY1) && (x + w > clipX0) && (y + h > clipY0) && (w > 0) && (h > 0);
+}
+
+/** \brief Set rotation.
+
+    Rotate the drawing coordinate system clockwise by ROTATE_0, ROTATE_90, ROTATE_180 or ROTATE_270. With ROTATE_90 and ROTATE_270 the screen is LCDHEIGHT wide and LCDWIDTH tall (portrait), see getLCDWidth() and getLCDHeight().
+
+    Coordinates are mapped to the panel once per primitive, so rectangles, lines and circles are drawn by the same span kernels as without rotation; bitmaps, blits and characters are rotated 8x8 pixels at a time with a bit matrix transpose. The clip rectangle stack is reset. The screen buffer itself, display(), markDirty() and the widgets that write the screen buffer directly (text grid, tile map, chart, animation, gray) keep using panel coordinates; the sprite layer and numeric readout draw in drawing coordinates, inside the current viewport, and map the areas they send with mapToPanel().
+*/
+void MicroOLED::setRotation(uint8_t rotation) {
+	this->rotation = rotation & 3;
+	resetClip();
+}
+
+/** \brief Get rotation.
+
+    The current drawing rotation, ROTATE_0 to ROTATE_270.
+*/
+uint8_t MicroOLED::getRotation(void) {
+	return rotation;
+}
+
+/** \brief Map drawing rectangle to panel.
+
+    Map the width x height rectangle at x,y in drawing coordinates (relative to the current viewport) to the panel rectangle covering the same pixels, e.g. to pass an area drawn with the drawing functions to display() or markDirty().
+*/
+void MicroOLED::mapToPanel(int16_t &x, int16_t &y, int16_t &width, int16_t &height) {
+	x += originX;
+	y += originY;
+	toPanel(x, y, width, height);
+}
+
+/** \brief Map point to panel.
+
+    Map drawing position x,y (origin already applied) to the panel position of the same pixel.
+*/
+void MicroOLED::toPanel(int16_t &x, int16_t &y) {
+	int16_t t;
+
+	switch (rotation) {
+		case ROTATE_90:
+			t = x;
+			x = LCDWIDTH - 1 - y;
+			y = t;
+			break;
+		case ROTATE_180:
+			x = LCDWIDTH - 1 - x;
+			y = LCDHEIGHT - 1 - y;
+			break;
+		case ROTATE_270:
+			t = x;
+			x = y;
+			y = LCDHEIGHT - 1 - t;
+			break;
+	}
+}
+
+/** \brief Map rectangle to panel.
+
+    Map the width x height drawing rectangle at x,y (origin already applied) to the panel rectangle covering the same pixels.
+*/
+void MicroOLED::toPanel(int16_t &x, int16_t &y, int16_t &width, int16_t &height) {
+	int16_t t;
+
+	switch (rotation) {
+		case ROTATE_90:
+			t = x;
+			x = LCDWIDTH - y - height;
+			y = t;
+			swap(width, height);
+			break;
+		case ROTATE_180:
+			x = LCDWIDTH - x - width;
+			y = LCDHEIGHT - y - height;
+			break;
+		case ROTATE_270:
+			t = x;
+			x = y;
+			y = LCDHEIGHT - t - width;
+			swap(width, height);
+			break;
 	}
 }
 
@@ -573,7 +1673,7 @@ void MicroOLED::circleFill(uint8_t x0, uint8_t y0, uint8_t radius, uint8_t color
     The height of the LCD return as byte.
 */
 uint8_t MicroOLED::getLCDHeight(void) {
-	return LCDHEIGHT;
+	return (rotation & 1) ? LCDWIDTH : LCDHEIGHT;
 }
 
 /** \brief Get LCD width.
@@ -581,7 +1681,7 @@ uint8_t MicroOLED::getLCDHeight(void) {
     The width of the LCD return as byte.
 */	
 uint8_t MicroOLED::getLCDWidth(void) {
-	return LCDWIDTH;
+	return (rotation & 1) ? LCDHEIGHT : LCDWIDTH;
 }
 
 /** \brief Get font width.
@@ -649,6 +1749,17 @@ uint8_t MicroOLED::setFontType(uint8_t type) {
 	return true;
 }
 
+/** \brief Get font data.
+
+    Return a pointer to the raw data of font type (header bytes followed by the bitmaps), or NULL if there is no such font. Lets other modules render glyphs without including their own copy of the font.
+*/
+const unsigned char *MicroOLED::getFontData(uint8_t type) {
+	if (type>=TOTALFONTS)
+	return NULL;
+
+	return fontsPointer[type];
+}
+
 /** \brief Set color.
 
     Set the current draw's color. Only WHITE and BLACK available.
@@ -669,7 +1780,7 @@ void MicroOLED::setDrawMode(uint8_t mode) {
 
     Draw character c using current color and current draw mode at x,y.
 */
-void  MicroOLED::drawChar(uint8_t x, uint8_t y, uint8_t c) {
+void  MicroOLED::drawChar(int16_t x, int16_t y, uint8_t c) {
 	drawChar(x,y,c,foreColor,drawMode);
 }
 
@@ -677,75 +1788,101 @@ void  MicroOLED::drawChar(uint8_t x, uint8_t y, uint8_t c) {
 
     Draw character c using color and draw mode at x,y.
 */
-void  MicroOLED::drawChar(uint8_t x, uint8_t y, uint8_t c, uint8_t color, uint8_t mode) {
+void  MicroOLED::drawChar(int16_t x, int16_t y, uint8_t c, uint8_t color, uint8_t mode) {
+	STAT_ADD(primitives, 1);
 	// TODO - New routine to take font of any height, at the moment limited to font height in multiple of 8 pixels
 
 	uint8_t rowsToDraw,row, tempC;
-	uint8_t i,j,temp;
-	uint16_t charPerBitmapRow,charColPositionOnBitmap,charRowPositionOnBitmap,charBitmapStartPosition;
+	uint8_t i,temp,columns;
+	uint16_t charPerBitmapRow,charColPositionOnBitmap,charRowPositionOnBitmap,charBitmapStartPosition,rowStride;
 	
 	if ((c<fontStartChar) || (c>(fontStartChar+fontTotalChar-1)))		// no bitmap for the required c
 	return;
-	
+
 	tempC=c-fontStartChar;
 
 	// each row (in datasheet is call page) is 8 bits high, 16 bit high character will have 2 rows to be drawn
 	rowsToDraw=fontHeight/8;	// 8 is LCD's page size, see SSD1306 datasheet
 	if (rowsToDraw<=1) rowsToDraw=1;
 
-	// the following draw function can draw anywhere on the screen, but SLOW pixel by pixel draw
 	if (rowsToDraw==1) {
-		for  (i=0;i<fontWidth+1;i++) {
-			if (i==fontWidth) // this is done in a weird way because for 5x7 font, there is no margin, this code add a margin after col 5
-			temp=0;
-			else
-			temp = *(fontsPointer[fontType]+FONTHEADERSIZE+(tempC*fontWidth)+i);
-			
-			for (j=0;j<8;j++) {			// 8 is the LCD's page height (see datasheet for explanation)
-				if (temp & 0x1) {
-					pixel(x+i, y+j, color,mode);
-				}
-				else {
-					pixel(x+i, y+j, !color,mode);
-				}
-				
-				temp >>=1;
+		columns=fontWidth+1;	// for 5x7 font there is no margin, this adds a margin after col 5
+		charBitmapStartPosition=tempC*fontWidth;
+		rowStride=0;
+	}
+	else {
+		// font height over 8 bit
+		// take character "0" ASCII 48 as example
+		charPerBitmapRow=fontMapWidth/fontWidth;  // 256/8 =32 char per row
+		charColPositionOnBitmap=tempC % charPerBitmapRow;  // =16
+		charRowPositionOnBitmap=int(tempC/charPerBitmapRow); // =1
+		charBitmapStartPosition=(charRowPositionOnBitmap * fontMapWidth * (fontHeight/8)) + (charColPositionOnBitmap * fontWidth) ;
+		columns=fontWidth;
+		rowStride=fontMapWidth;
+	}
+
+	// each font byte is an 8 pixel column, set bits are drawn in color and clear bits in !color,
+	// one pass per color so the operation is picked once per pass rather than per pixel
+	const unsigned char *glyph = fontsPointer[fontType]+FONTHEADERSIZE+charBitmapStartPosition;
+
+	if (rotation != ROTATE_0) {
+		// copy the cell to a page-major bitmap with the pixels to draw in color set, the rotating blit turns it
+		uint8_t cell[16 * 6];	// largest font cell is 12x48
+		uint8_t invert = (color==WHITE) ? 0x00 : 0xFF;
+
+		if (columns * rowsToDraw > sizeof(cell))
+		return;
+		for (row=0; row<rowsToDraw; row++) {
+			for (i=0; i<columns; i++) {
+				temp = (i<fontWidth) ? glyph[i+(row*rowStride)] : 0;
+				cell[i+(row*columns)] = temp ^ invert;
 			}
 		}
+		blitKernel(x, y, cell, NULL, columns, rowsToDraw*8, 0, 0, columns, rowsToDraw*8, (mode==XOR) ? ROP_XOR : ROP_COPY);
 		return;
 	}
 
-	// font height over 8 bit
-	// take character "0" ASCII 48 as example
-	charPerBitmapRow=fontMapWidth/fontWidth;  // 256/8 =32 char per row
-	charColPositionOnBitmap=tempC % charPerBitmapRow;  // =16
-	charRowPositionOnBitmap=int(tempC/charPerBitmapRow); // =1
-	charBitmapStartPosition=(charRowPositionOnBitmap * fontMapWidth * (fontHeight/8)) + (charColPositionOnBitmap * fontWidth) ;
-
-	// each row on LCD is 8 bit height (see datasheet for explanation)
-	for(row=0;row<rowsToDraw;row++) {
-		for (i=0; i<fontWidth;i++) {
-			temp = *(fontsPointer[fontType]+FONTHEADERSIZE+(charBitmapStartPosition+i+(row*fontMapWidth)));
-			for (j=0;j<8;j++) {			// 8 is the LCD's page height (see datasheet for explanation)
-				if (temp & 0x1) {
-					pixel(x+i,y+j+(row*8), color, mode);
-				}
-				else {
-					pixel(x+i,y+j+(row*8), !color, mode);
-				}
-				temp >>=1;
+	// whole character outside the clip rectangle
+	x += originX;
+	y += originY;
+	if ((x+columns <= clipX0) || (y+rowsToDraw*8 <= clipY0) || (x >= clipX1) || (y >= clipY1))
+	return;
+
+	auto drawPass = [&](auto op, uint8_t invert) {
+		for (row=0; row<rowsToDraw; row++) {
+			if ((y+(row*8)+8 <= clipY0) || (y+(row*8) >= clipY1))	// e.g. outside the drawPages() strip
+			continue;
+
+			for (i=0; i<columns; i++) {
+				int16_t col = x + i;
+				if ((col < clipX0) || (col >= clipX1))
+				continue;
+
+				temp = (i<fontWidth) ? glyph[i+(row*rowStride)] : 0;
+				column8(op, col, y+(row*8), temp ^ invert, clipY0, clipY1);
 			}
 		}
-	}
-
+	};
+	withOp(color, mode, [&](auto op) {
+		drawPass(op, 0x00);
+	});
+	withOp(!color, mode, [&](auto op) {
+		drawPass(op, 0xFF);
+	});
+	STAT_ADD(pixels, columns * rowsToDraw * 8);
 }
 
 /** \brief Stop scrolling.
 
-    Stop the scrolling of graphics on the OLED.
+    Stop the scrolling of graphics on the OLED. Nothing is sent if the display is not scrolling. The controller memory has to be rewritten after a scroll, so the next display() sends every page.
 */
 void MicroOLED::scrollStop(void){
+	if (!shadowScrolling)
+	return;
+
 	command(DEACTIVATESCROLL);
+	shadowScrolling = false;
+	shadowPagesValid = 0;	// pages sent while scrolling were moved since
 }
 
 /** \brief Right scrolling.
@@ -757,6 +1894,8 @@ void MicroOLED::scrollRight(uint8_t start, uint8_t stop){
 	return;
 	scrollStop();		// need to disable scrolling before starting to avoid memory corrupt
 	command(RIGHTHORIZONTALSCROLL, 0x00, start, 0x07, stop, 0x00, 0xFF, ACTIVATESCROLL); // scroll speed frames , TODO
+	shadowScrolling = true;
+	shadowPagesValid = 0;	// scrolling moves the controller memory
 }
 
 /** \brief Left scrolling.
@@ -767,36 +1906,47 @@ void MicroOLED::scrollLeft(uint8_t start, uint8_t stop){
 	return;
 	scrollStop();		// need to disable scrolling before starting to avoid memory corrupt
 	command(LEFTHORIZONTALSCROLL, 0x00, start, 0x07, stop, 0x00, 0xFF, ACTIVATESCROLL); // scroll speed frames , TODO
+	shadowScrolling = true;
+	shadowPagesValid = 0;	// scrolling moves the controller memory
 }
 
 /** \brief Vertical flip.
 
-Flip the graphics on the OLED vertically.
+Flip the graphics on the OLED vertically. Nothing is sent if the display is already flipped this way.
 */
 void MicroOLED::flipVertical(boolean flip) {
+	if (flip == shadowFlipV)
+	return;
+
 	if (flip) {
 		command(COMSCANINC);
 	}
 	else {
 		command(COMSCANDEC);
 	}
+	shadowFlipV = flip;
 }
 
 /** \brief Horizontal flip.
 
-    Flip the graphics on the OLED horizontally.
+    Flip the graphics on the OLED horizontally. Nothing is sent if the display is already flipped this way.
 */	
 void MicroOLED::flipHorizontal(boolean flip) {
+	if (flip == shadowFlipH)
+	return;
+
 	if (flip) {
 		command(SEGREMAP | 0x0);
 	}
 	else {
 		command(SEGREMAP | 0x1);
 	}
+	shadowFlipH = flip;
+	shadowPagesValid = 0;	// the remap applies to data written from now on
 }
 
 /*
-	Return a pointer to the start of the RAM screen buffer for direct access.
+	Return a pointer to the start of the RAM screen buffer for direct access. Built with MICROOLED_PAGEMODE this is the single page strip buffer used by drawPages().
 */
 uint8_t *MicroOLED::getScreenBuffer(void) {
 	return screenmemory;
@@ -804,10 +1954,255 @@ uint8_t *MicroOLED::getScreenBuffer(void) {
 
 /*
 Draw Bitmap image on screen. The array for the bitmap can be stored in main program file, so user don't have to mess with the library files. 
-To use, create const uint8_t array that is LCDWIDTH x LCDHEIGHT pixels (LCDWIDTH * LCDHEIGHT / 8 bytes). Then call .drawBitmap and pass it the array. 
+To use, create const uint8_t array that is LCDWIDTH x LCDHEIGHT pixels (LCDWIDTH * LCDHEIGHT / 8 bytes), or LCDHEIGHT x LCDWIDTH when rotated to portrait. Then call .drawBitmap and pass it the array. 
 */	
 void MicroOLED::drawBitmap(const uint8_t * bitArray)
 {
-	for (int i=0; i<(LCDWIDTH * LCDHEIGHT / 8); i++)
-		screenmemory[i] = bitArray[i];
+#ifndef MICROOLED_PAGEMODE
+	if ((clipDepth == 0) && (rotation == ROTATE_0) && (stripY0 == 0) && (stripY1 == LCDHEIGHT)) {
+		STAT_ADD(primitives, 1);
+		STAT_ADD(pixels, LCDWIDTH * LCDHEIGHT);
+		for (int i=0; i<(LCDWIDTH * LCDHEIGHT / 8); i++)
+			screenmemory[i] = bitArray[i];
+		return;
+	}
+#endif
+	blitKernel(0, 0, bitArray, NULL, getLCDWidth(), getLCDHeight(), 0, 0, getLCDWidth(), getLCDHeight(), ROP_COPY);	// honour the viewport, rotation and drawPages() strips
+}
+
+/** \brief Draw positioned bitmap.
+
+    Copy a width x height bitmap to x,y of the screen buffer, replacing what is underneath. The bitmap uses the screen buffer's page-major layout (see blit()) and is clipped at the screen edges, so x and y may be negative.
+*/
+void MicroOLED::drawBitmap(int16_t x, int16_t y, const uint8_t *bitArray, uint8_t width, uint8_t height)
+{
+	blitKernel(x, y, bitArray, NULL, width, height, 0, 0, width, height, ROP_COPY);
+}
+
+/** \brief Draw positioned bitmap with transparency mask.
+
+    Same as above, but only pixels set in mask are drawn; everything else is left untouched. mask has the same size and layout as the bitmap.
+*/
+void MicroOLED::drawBitmap(int16_t x, int16_t y, const uint8_t *bitArray, const uint8_t *mask, uint8_t width, uint8_t height)
+{
+	blitKernel(x, y, bitArray, mask, width, height, 0, 0, width, height, ROP_COPY);
+}
+
+/** \brief Block transfer with raster operation.
+
+    Combine the whole srcWidth x srcHeight source image with the screen buffer at x,y using raster operation rop (ROP_COPY, ROP_OR, ROP_AND, ROP_XOR or ROP_NOTCOPY). The source uses the same page-major layout as the screen buffer: one byte holds 8 vertical pixels, pages of srcWidth bytes follow each other. x and y may be negative or reach past the screen edges, the image is clipped.
+*/
+void MicroOLED::blit(int16_t x, int16_t y, const uint8_t *src, uint8_t srcWidth, uint8_t srcHeight, uint8_t rop) {
+	blit(x, y, src, srcWidth, srcHeight, 0, 0, srcWidth, srcHeight, rop);
+}
+
+/** \brief Block transfer of a source rectangle with raster operation.
+
+    Same as above, but only the w x h rectangle at sx,sy of the source image is transferred to x,y. The rectangle is clipped against both the source image and the screen.
+*/
+void MicroOLED::blit(int16_t x, int16_t y, const uint8_t *src, uint8_t srcWidth, uint8_t srcHeight, uint8_t sx, uint8_t sy, uint8_t w, uint8_t h, uint8_t rop) {
+	blitKernel(x, y, src, NULL, srcWidth, srcHeight, sx, sy, w, h, rop);
+}
+
+/** \brief Gather a column of a page-major image.
+
+    Return pixels of column col, pages page0 to page1, of a page-major image width bytes wide as one word, page0 in the lowest byte.
+*/
+static inline uint64_t gatherColumn(const uint8_t *image, uint8_t width, int16_t col, uint8_t page0, uint8_t page1) {
+	const uint8_t *p = image + col + page0 * width;
+	uint64_t bits = 0;
+
+	for (uint8_t page = 0; page <= page1 - page0; page++, p += width) {
+		bits |= (uint64_t)*p << (page * 8);
+	}
+	return bits;
+}
+
+/** \brief BitBLT in drawing coordinates.
+
+    Clip the w x h source rectangle at sx,sy of a page-major image against the source image, then translate it by the viewport origin. Without rotation this is a single blitPanel(), rotated it goes through blitBlocks().
+*/
+void MicroOLED::blitKernel(int16_t x, int16_t y, const uint8_t *src, const uint8_t *mask, uint8_t srcWidth, uint8_t srcHeight, int16_t sx, int16_t sy, int16_t w, int16_t h, uint8_t rop) {
+	// clip against the source image
+	if ((sx >= srcWidth) || (sy >= srcHeight))
+	return;
+	if (w > srcWidth - sx) w = srcWidth - sx;
+	if (h > srcHeight - sy) h = srcHeight - sy;
+	if ((w <= 0) || (h <= 0))
+	return;
+
+	x += originX;
+	y += originY;
+	if (rotation == ROTATE_0) {
+		blitPanel(x, y, src, mask, srcWidth, srcHeight, sx, sy, w, h, rop);
+		return;
+	}
+	blitBlocks(x, y, src, mask, srcWidth, srcHeight, sx, sy, w, h, rop, IMAGE_PAGEMAJOR);
+}
+
+/** \brief Block transfer of a row-major image.
+
+    Combine a srcWidth x srcHeight row-major 1bpp image (rows of (srcWidth + 7) / 8 bytes, as in XBM and PBM P4 files or data received over a serial link) with the screen buffer at x,y using raster operation rop. format is IMAGE_XBM, IMAGE_PBM or a combination of ROWMAJOR_LSBFIRST/ROWMAJOR_MSBFIRST and ROWMAJOR_INVERT. The image is converted 8x8 pixels at a time with a bit matrix transpose straight into the screen buffer, clipped like blit().
+*/
+void MicroOLED::blitRowMajor(int16_t x, int16_t y, const uint8_t *src, uint8_t srcWidth, uint8_t srcHeight, uint8_t format, uint8_t rop) {
+	if ((srcWidth == 0) || (srcHeight == 0))
+	return;
+
+	blitBlocks(x + originX, y + originY, src, NULL, srcWidth, srcHeight, 0, 0, srcWidth, srcHeight, rop, format & ~IMAGE_PAGEMAJOR);
+}
+
+#ifndef MICROOLED_PAGEMODE
+/** \brief Draw run-length encoded frame.
+
+    Decode a full frame in the format of SFE_MicroOLED_RLE.h into the screen buffer. With ROP_XOR the frame is XORed into the buffer instead of replacing it, which applies an animation delta frame; other raster operations copy. Like the screen buffer itself the frame is in panel coordinates, clipping and rotation do not apply. Return a pointer just past the frame, i.e. to the next frame of an animation.
+*/
+const uint8_t *MicroOLED::drawRLE(const uint8_t *rle, uint8_t rop) {
+	STAT_ADD(primitives, 1);
+	STAT_ADD(pixels, LCDWIDTH * LCDHEIGHT);
+	return rleDecode(rle, screenmemory, LCDWIDTH * LCDHEIGHT / 8, rop == ROP_XOR);
+}
+#endif
+
+/** \brief BitBLT in 8x8 blocks.
+
+    Map the w x h source rectangle at sx,sy (already clipped to the source, x,y already translated) to the panel and cover the destination with 8x8 blocks. Each block is gathered from the source (and mask, page-major only) in format, turned to the rotation with a bit matrix transpose and byte/bit reversals, and transferred with blitPanel().
+*/
+void MicroOLED::blitBlocks(int16_t x, int16_t y, const uint8_t *src, const uint8_t *mask, uint8_t srcWidth, uint8_t srcHeight, int16_t sx, int16_t sy, int16_t w, int16_t h, uint8_t rop, uint8_t format) {
+	uint8_t block[8], maskBlock[8];
+	int16_t pw, ph;
+
+	pw = w;
+	ph = h;
+	toPanel(x, y, pw, ph);
+	if ((x >= clipX1) || (y >= clipY1) || (x + pw <= clipX0) || (y + ph <= clipY0))
+	return;
+
+	for (int16_t a0 = 0; a0 < pw; a0 += 8) {
+		if ((x + a0 + 8 <= clipX0) || (x + a0 >= clipX1))
+		continue;
+
+		for (int16_t b0 = 0; b0 < ph; b0 += 8) {
+			int16_t col0, row0;
+			uint64_t s, m = 0;
+
+			if ((y + b0 + 8 <= clipY0) || (y + b0 >= clipY1))
+			continue;
+
+			// source block whose pixels land in panel block a0,b0, and how to turn it
+			switch (rotation) {
+				case ROTATE_0:
+					col0 = sx + a0;
+					row0 = sy + b0;
+					break;
+				case ROTATE_90:
+					col0 = sx + b0;
+					row0 = sy + h - 8 - a0;
+					break;
+				case ROTATE_180:
+					col0 = sx + w - 8 - a0;
+					row0 = sy + h - 8 - b0;
+					break;
+				default:	// ROTATE_270
+					col0 = sx + w - 8 - b0;
+					row0 = sy + a0;
+					break;
+			}
+			if (format & IMAGE_PAGEMAJOR) {
+				s = gatherBlock(src, srcWidth, srcHeight, col0, row0);
+				if (mask)
+				m = gatherBlock(mask, srcWidth, srcHeight, col0, row0);
+			}
+			else {
+				s = gatherRowBlock(src, srcWidth, srcHeight, col0, row0, format);
+			}
+
+			switch (rotation) {
+				case ROTATE_0:
+					break;
+				case ROTATE_90:
+					s = reverseBytes(transpose8(s));
+					m = reverseBytes(transpose8(m));
+					break;
+				case ROTATE_180:
+					s = reverseBits(reverseBytes(s));
+					m = reverseBits(reverseBytes(m));
+					break;
+				default:	// ROTATE_270
+					s = reverseBits(transpose8(s));
+					m = reverseBits(transpose8(m));
+					break;
+			}
+			for (uint8_t i = 0; i < 8; i++) {
+				block[i] = s >> (i * 8);
+				maskBlock[i] = m >> (i * 8);
+			}
+
+			blitPanel(x + a0, y + b0, block, mask ? maskBlock : NULL, 8, 8, 0, 0, (pw - a0 < 8) ? pw - a0 : 8, (ph - b0 < 8) ? ph - b0 : 8, rop);
+		}
+	}
+}
+
+/** \brief BitBLT kernel.
+
+    Clip the transfer to panel position x,y once, then combine source and screen buffer one column at a time: the clipped source column (and mask column, if any) is gathered into a 64-bit word, shifted to the destination row in one step, and merged with the destination column word under a row mask, so an unaligned y costs no more than an aligned one. Only pixels set in both the row mask and mask (when not NULL) are changed.
+*/
+void MicroOLED::blitPanel(int16_t x, int16_t y, const uint8_t *src, const uint8_t *mask, uint8_t srcWidth, uint8_t srcHeight, int16_t sx, int16_t sy, int16_t w, int16_t h, uint8_t rop) {
+	uint8_t srcPage0, srcPage1, dstPage0, dstPage1, srcShift, page;
+	uint64_t rowMask, s, m, d;
+
+	// clip against the source image
+	if ((sx >= srcWidth) || (sy >= srcHeight))
+	return;
+	if (w > srcWidth - sx) w = srcWidth - sx;
+	if (h > srcHeight - sy) h = srcHeight - sy;
+
+	// clip against the clip rectangle
+	if (x < clipX0) {
+		sx += clipX0 - x;
+		w -= clipX0 - x;
+		x = clipX0;
+	}
+	if (y < clipY0) {
+		sy += clipY0 - y;
+		h -= clipY0 - y;
+		y = clipY0;
+	}
+	if (w > clipX1 - x) w = clipX1 - x;
+	if (h > clipY1 - y) h = clipY1 - y;
+	if ((w <= 0) || (h <= 0))
+	return;
+
+	STAT_ADD(primitives, 1);
+	STAT_ADD(pixels, w * h);
+
+	srcPage0 = sy / 8;
+	srcPage1 = (sy + h - 1) / 8;
+	srcShift = sy % 8;
+	dstPage0 = y / 8;
+	dstPage1 = (y + h - 1) / 8;
+	rowMask = (((uint64_t)1 << h) - 1) << y;
+
+	for (int16_t col = 0; col < w; col++) {
+		s = (gatherColumn(src, srcWidth, sx + col, srcPage0, srcPage1) >> srcShift) << y;
+		m = rowMask;
+		if (mask)
+		m &= (gatherColumn(mask, srcWidth, sx + col, srcPage0, srcPage1) >> srcShift) << y;
+
+		d = 0;
+		for (page = dstPage0; page <= dstPage1; page++) {
+			d |= (uint64_t)screenmemory[bufferIndex(x + col, page)] << (page * 8);
+		}
+
+		switch (rop) {
+			case ROP_OR:		d |= s & m;					break;
+			case ROP_AND:		d &= s | ~m;				break;
+			case ROP_XOR:		d ^= s & m;					break;
+			case ROP_NOTCOPY:	d = (d & ~m) | (~s & m);	break;
+			default:			d = (d & ~m) | (s & m);		break;	// ROP_COPY
+		}
+
+		for (page = dstPage0; page <= dstPage1; page++) {
+			screenmemory[bufferIndex(x + col, page)] = d >> (page * 8);
+		}
+	}
 }
@@ -33,6 +33,9 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #ifndef SFE_MICROOLED_H
 #define SFE_MICROOLED_H
 
+#include "SFE_MicroOLED_Bits.h"
+#include "SFE_MicroOLED_RLE.h"
+
 static inline void swap(uint8_t &a, uint8_t &b)
 {
     uint8_t t = a;
@@ -40,6 +43,14 @@ static inline void swap(uint8_t &a, uint8_t &b)
     a = b;
     b = t;
 }
+
+static inline void swap(int16_t &a, int16_t &b)
+{
+    int16_t t = a;
+    
+    a = b;
+    b = t;
+}
  
 #ifndef _BV
 #define _BV(bit) (1<<(bit))
@@ -62,6 +73,29 @@ static inline void swap(uint8_t &a, uint8_t &b)
 #define PAGE				0
 #define ALL					1
 
+// Raster operations for blit()
+#define ROP_COPY			0	// destination = source
+#define ROP_OR				1	// destination |= source
+#define ROP_AND				2	// destination &= source
+#define ROP_XOR				3	// destination ^= source
+#define ROP_NOTCOPY			4	// destination = ~source
+
+// Fill rules for polygonFill()
+#define FILL_EVENODD		0
+#define FILL_NONZERO		1
+#define MAXPOLYGONVERTICES	16
+
+#define MAXCLIPDEPTH		4	// Clip rectangles / viewports that can be pushed
+
+// Drawing rotations for setRotation(), clockwise
+#define ROTATE_0			0
+#define ROTATE_90			1
+#define ROTATE_180			2
+#define ROTATE_270			3
+
+#define COMMANDQUEUESIZE	32	// Bytes a MicroOLED::CommandQueue holds before it sends them
+#define RLECHUNKSIZE		32	// Bytes displayRLE() decodes before it sends them
+
 #define SETCONTRAST 		0x81
 #define DISPLAYALLONRESUME 	0xA4
 #define DISPLAYALLON 		0xA5
@@ -99,6 +133,24 @@ static inline void swap(uint8_t &a, uint8_t &b)
 
 typedef bool boolean;
 
+#ifdef MICROOLED_STATS
+// Instrumentation counters, see MicroOLED::getStats()
+struct MicroOLEDStats {
+	uint32_t bytesSent;			// command and data bytes sent over SPI
+	uint32_t csAssertions;		// SPI transfers (CS low/high cycles)
+	uint32_t commandTransfers;	// command() transfers, each may carry several commands
+	uint32_t flushes;			// display() calls and other transfers of the screen buffer
+	uint32_t flushBytes;		// screen buffer bytes sent by those flushes
+	uint32_t lastFlushUs;		// duration of the last flush in microseconds
+	uint32_t maxFlushUs;
+	uint32_t totalFlushUs;
+	uint32_t primitives;		// drawing primitive calls (rect counts its lines)
+	uint32_t pixels;			// pixels written into the screen buffer by those primitives
+};
+// Average share of the screen buffer sent per flush, 1.0 when only full frames are sent
+#define MICROOLED_DIRTY_RATIO(s)	((s).flushes ? (float)(s).flushBytes / ((s).flushes * (LCDWIDTH * LCDHEIGHT / 8)) : 0.0f)
+#endif
+
 class MicroOLED {
 public:
 	// Constructor
@@ -108,10 +160,29 @@ public:
 		rstPin = 1;
 		dcPin = 0;
 		csPin = 1;
+
+		// Controller power-on defaults, overwritten by init()
+		shadowContrast = 0x7F;
+		shadowInverted = false;
+		shadowFlipV = false;
+		shadowFlipH = false;
+		shadowScrolling = false;
+		windowValid = false;
+		shadowPagesValid = 0;
+		readyState = false;
+		dirtyCol0 = LCDWIDTH;
+		rotation = ROTATE_0;
+		resetStrip();
+		resetClip();
+#ifdef MICROOLED_STATS
+		resetStats();
+#endif
 	};
 	
 	// Initialize SPI mode and frequency and SSD1306 for particular display
 	void init(int spi_mode, int spi_freq);
+	bool initAsync(EventQueue &queue, int spi_mode, int spi_freq, Callback<void()> ready = nullptr);
+	bool isReady(void);
 	
 	// Standard text output functions
 	void putc(char c);
@@ -123,39 +194,93 @@ public:
 	void command(uint8_t c1, uint8_t c2);
 	void command(uint8_t c1, uint8_t c2, uint8_t c3);
 	void command(uint8_t c1, uint8_t c2, uint8_t c3, uint8_t c4, uint8_t c5, uint8_t c6, uint8_t c7, uint8_t c8);
+	void command(const uint8_t *cmds, size_t len);
+
+	// Collects command bytes and sends them under a single CS assertion on flush() or destruction
+	class CommandQueue {
+	public:
+		CommandQueue(MicroOLED &oled) : oled(oled), count(0) {};
+		~CommandQueue() { flush(); };
+		CommandQueue &add(uint8_t c);
+		CommandQueue &add(uint8_t c1, uint8_t c2);
+		CommandQueue &add(uint8_t c1, uint8_t c2, uint8_t c3);
+		CommandQueue &add(const uint8_t *cmds, size_t len);
+		void flush(void);
+	private:
+		MicroOLED &oled;
+		uint8_t buffer[COMMANDQUEUESIZE];
+		uint8_t count;
+	};
 	
 	// LCD Draw functions
 	void clear(uint8_t mode);
 	void clear(uint8_t mode, uint8_t c);
 	void invert(boolean inv);
 	void contrast(uint8_t contrast);
+#ifndef MICROOLED_PAGEMODE
+	// Full screen buffer transfers, not available when the library is built for page mode
 	void display(void);
+	void display(int16_t x, int16_t y, int16_t width, int16_t height);
+	void displayDirty(void);
+#endif
+	void displayFrame(const uint8_t *frame);
+	const uint8_t *displayRLE(const uint8_t *rle);
+	void markDirty(int16_t x, int16_t y, int16_t width, int16_t height);
+	// Page mode rendering: draw is called once per page with the clip rectangle set to that strip
+	// Built with MICROOLED_PAGEMODE the screen buffer holds one page; the Animation, Chart, Gray, Number, Sprites,
+	// TextGrid and TileMap modules work on the full screen buffer and stop the build with #error in that case
+	void drawPages(Callback<void()> draw);
 	void setCursor(uint8_t x, uint8_t y);
-	void pixel(uint8_t x, uint8_t y);
-	void pixel(uint8_t x, uint8_t y, uint8_t color, uint8_t mode);
-	void line(uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1);
-	void line(uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1, uint8_t color, uint8_t mode);
-	void lineH(uint8_t x, uint8_t y, uint8_t width);
-	void lineH(uint8_t x, uint8_t y, uint8_t width, uint8_t color, uint8_t mode);
-	void lineV(uint8_t x, uint8_t y, uint8_t height);
-	void lineV(uint8_t x, uint8_t y, uint8_t height, uint8_t color, uint8_t mode);
-	void rect(uint8_t x, uint8_t y, uint8_t width, uint8_t height);
-	void rect(uint8_t x, uint8_t y, uint8_t width, uint8_t height, uint8_t color , uint8_t mode);
-	void rectFill(uint8_t x, uint8_t y, uint8_t width, uint8_t height);
-	void rectFill(uint8_t x, uint8_t y, uint8_t width, uint8_t height, uint8_t color , uint8_t mode);
-	void circle(uint8_t x, uint8_t y, uint8_t radius);
-	void circle(uint8_t x, uint8_t y, uint8_t radius, uint8_t color, uint8_t mode);
-	void circleFill(uint8_t x0, uint8_t y0, uint8_t radius);
-	void circleFill(uint8_t x0, uint8_t y0, uint8_t radius, uint8_t color, uint8_t mode);
-	void drawChar(uint8_t x, uint8_t y, uint8_t c);
-	void drawChar(uint8_t x, uint8_t y, uint8_t c, uint8_t color, uint8_t mode);
+	// Coordinates are signed, shapes partly or wholly off the screen are clipped
+	void pixel(int16_t x, int16_t y);
+	void pixel(int16_t x, int16_t y, uint8_t color, uint8_t mode);
+	void line(int16_t x0, int16_t y0, int16_t x1, int16_t y1);
+	void line(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint8_t color, uint8_t mode);
+	void lineH(int16_t x, int16_t y, uint8_t width);
+	void lineH(int16_t x, int16_t y, uint8_t width, uint8_t color, uint8_t mode);
+	void lineV(int16_t x, int16_t y, uint8_t height);
+	void lineV(int16_t x, int16_t y, uint8_t height, uint8_t color, uint8_t mode);
+	void rect(int16_t x, int16_t y, uint8_t width, uint8_t height);
+	void rect(int16_t x, int16_t y, uint8_t width, uint8_t height, uint8_t color , uint8_t mode);
+	void rectFill(int16_t x, int16_t y, uint8_t width, uint8_t height);
+	void rectFill(int16_t x, int16_t y, uint8_t width, uint8_t height, uint8_t color , uint8_t mode);
+	void circle(int16_t x, int16_t y, uint8_t radius);
+	void circle(int16_t x, int16_t y, uint8_t radius, uint8_t color, uint8_t mode);
+	void circleFill(int16_t x0, int16_t y0, uint8_t radius);
+	void circleFill(int16_t x0, int16_t y0, uint8_t radius, uint8_t color, uint8_t mode);
+	void polygonFill(const int16_t *x, const int16_t *y, uint8_t count, uint8_t rule);
+	void polygonFill(const int16_t *x, const int16_t *y, uint8_t count, uint8_t rule, uint8_t color, uint8_t mode);
+	void triangleFill(int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_t x2, int16_t y2);
+	void triangleFill(int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_t x2, int16_t y2, uint8_t color, uint8_t mode);
+	void drawChar(int16_t x, int16_t y, uint8_t c);
+	void drawChar(int16_t x, int16_t y, uint8_t c, uint8_t color, uint8_t mode);
 	void drawBitmap(const uint8_t * bitArray);
+	void drawBitmap(int16_t x, int16_t y, const uint8_t *bitArray, uint8_t width, uint8_t height);
+	void drawBitmap(int16_t x, int16_t y, const uint8_t *bitArray, const uint8_t *mask, uint8_t width, uint8_t height);
+	void blit(int16_t x, int16_t y, const uint8_t *src, uint8_t srcWidth, uint8_t srcHeight, uint8_t rop);
+	void blit(int16_t x, int16_t y, const uint8_t *src, uint8_t srcWidth, uint8_t srcHeight, uint8_t sx, uint8_t sy, uint8_t w, uint8_t h, uint8_t rop);
+	void blitRowMajor(int16_t x, int16_t y, const uint8_t *src, uint8_t srcWidth, uint8_t srcHeight, uint8_t format, uint8_t rop);
+#ifndef MICROOLED_PAGEMODE
+	const uint8_t *drawRLE(const uint8_t *rle, uint8_t rop = ROP_COPY);
+#endif
 	uint8_t getLCDWidth(void);
 	uint8_t getLCDHeight(void);
 	void setColor(uint8_t color);
 	void setDrawMode(uint8_t mode);
 	uint8_t *getScreenBuffer(void);
 
+	// Clip rectangle and viewport stack, honoured by all drawing functions (display and markDirty stay in screen coordinates)
+	boolean pushClip(int16_t x, int16_t y, uint8_t width, uint8_t height);
+	boolean pushViewport(int16_t x, int16_t y, uint8_t width, uint8_t height);
+	void popClip(void);
+	void resetClip(void);
+	boolean isVisible(int16_t x, int16_t y, uint8_t width, uint8_t height);
+
+	// Software rotation of the drawing coordinate system (display and markDirty stay in panel coordinates)
+	void setRotation(uint8_t rotation);
+	uint8_t getRotation(void);
+	void mapToPanel(int16_t &x, int16_t &y, int16_t &width, int16_t &height);
+
 	// Font functions
 	uint8_t getFontWidth(void);
 	uint8_t getFontHeight(void);
@@ -164,6 +289,7 @@ public:
 	uint8_t setFontType(uint8_t type);
 	uint8_t getFontStartChar(void);
 	uint8_t getFontTotalChar(void);
+	static const unsigned char *getFontData(uint8_t type);
 
 	// LCD Rotate Scroll functions	
 	void scrollRight(uint8_t start, uint8_t stop);
@@ -171,6 +297,15 @@ public:
 	void scrollStop(void);
 	void flipVertical(boolean flip);
 	void flipHorizontal(boolean flip);
+
+	// Re-send all shadowed controller settings (e.g. after a panel reset)
+	void resync(void);
+
+#ifdef MICROOLED_STATS
+	// Instrumentation counters
+	const MicroOLEDStats &getStats(void);
+	void resetStats(void);
+#endif
 	
 private:
 	SPI &miol_spi;
@@ -178,5 +313,70 @@ private:
 	uint8_t foreColor, drawMode, fontWidth, fontHeight, fontType, fontStartChar, fontTotalChar, cursorX, cursorY;
 	uint16_t fontMapWidth;
 	static const unsigned char *fontsPointer[];
+
+	void clippedPlot(int16_t x, int16_t y, uint8_t color, uint8_t mode);
+
+	// Rotation and the mapping from rotated drawing coordinates to panel coordinates
+	uint8_t rotation;
+	void toPanel(int16_t &x, int16_t &y);
+	void toPanel(int16_t &x, int16_t &y, int16_t &width, int16_t &height);
+	void fillRect(int16_t x, int16_t y, int16_t width, int16_t height, uint8_t color, uint8_t mode);
+
+	// Current clip rectangle (panel coordinates, x1/y1 exclusive) and drawing origin (drawing coordinates), plus saved states
+	struct ClipState {
+		int16_t x0, y0, x1, y1, originX, originY;
+	};
+	int16_t clipX0, clipY0, clipX1, clipY1, originX, originY;
+	ClipState clipStack[MAXCLIPDEPTH];
+	uint8_t clipDepth;
+	void blitKernel(int16_t x, int16_t y, const uint8_t *src, const uint8_t *mask, uint8_t srcWidth, uint8_t srcHeight, int16_t sx, int16_t sy, int16_t w, int16_t h, uint8_t rop);
+	void blitBlocks(int16_t x, int16_t y, const uint8_t *src, const uint8_t *mask, uint8_t srcWidth, uint8_t srcHeight, int16_t sx, int16_t sy, int16_t w, int16_t h, uint8_t rop, uint8_t format);
+	void blitPanel(int16_t x, int16_t y, const uint8_t *src, const uint8_t *mask, uint8_t srcWidth, uint8_t srcHeight, int16_t sx, int16_t sy, int16_t w, int16_t h, uint8_t rop);
+
+	// Panel rows the drawing functions may touch: the whole screen, or the page strip drawPages() is rendering
+	int16_t stripY0, stripY1;
+	void resetStrip(void);
+
+	// Non-blocking initialisation state, see initAsync()
+	EventQueue *initQueue;
+	Callback<void()> initReady;
+	Timeout initRetry;		// posts a step the queue had no room for
+	uint8_t initStep;
+	bool readyState;
+	void initState(int spi_mode, int spi_freq);
+	void initController(void);
+	void initAsyncStep(void);
+	void initAsyncNext(std::chrono::milliseconds delay);
+	void initAsyncRetry(void);
+
+#ifdef MICROOLED_STATS
+	MicroOLEDStats stats;
+	Timer statsTimer;
+	void statsFlushBegin(void);
+	void statsFlushEnd(uint16_t bytes);
+#endif
+
+	// Shadow of the controller settings last written, used to skip redundant commands
+	uint8_t shadowContrast;
+	bool shadowInverted, shadowFlipV, shadowFlipH, shadowScrolling;
+
+	// Address window last set in the controller (horizontal addressing mode is kept permanently)
+	uint8_t windowCol0, windowCol1, windowPage0, windowPage1;
+	uint16_t windowOffset;	// bytes written since the address pointer was last at the window origin
+	bool windowValid;
+
+	// Hash of each visible page as last sent by display(); a page whose bit in shadowPagesValid is set holds that content in the controller
+	uint32_t shadowPageHash[LCDHEIGHT / 8];
+	uint8_t shadowPagesValid;
+	void setWindow(uint8_t col0, uint8_t col1, uint8_t page0, uint8_t page1);
+	void advanceWindow(uint16_t bytes);
+	void data(const uint8_t *buf, size_t len);
+	void fillController(uint8_t c);
+#ifndef MICROOLED_PAGEMODE
+	void flushWindow(uint8_t col0, uint8_t col1, uint8_t page0, uint8_t page1);
+#endif
+
+	// Screen buffer area changed since the last flush, empty while dirtyCol0 >= LCDWIDTH
+	uint8_t dirtyCol0, dirtyCol1, dirtyPage0, dirtyPage1;
 };
 #endif
@@ -0,0 +1,159 @@
+/******************************************************************************
+SFE_MicroOLED_Animation.cpp
+Animation player for the MicroOLED mbed Library
+
+This file implements playback of delta frame animations: the runs of each
+frame are copied into the screen buffer and sent as separate windows, paced
+by a ticker whose handler posts the work to an event queue.
+
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later
+version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include "mbed.h"
+#include "SFE_MicroOLED_Animation.h"
+
+/** \brief Create animation player.
+
+    Nothing is shown until begin() or start().
+*/
+MicroOLEDAnimation::MicroOLEDAnimation(MicroOLED &oled) : oled(oled)
+{
+	animation = NULL;
+	next = NULL;
+	second = NULL;
+	frames = 0;
+	frame = 0;
+	loop = false;
+	queue = NULL;
+	pending = false;
+	running = false;
+}
+
+/** \brief Show first frame.
+
+    Clear the screen buffer, apply the first frame of animation (a frame count followed by delta frame records, see SFE_MicroOLED_Delta.h) and send the whole screen once, so the controller and the screen buffer agree before deltas are sent. The animation covers the whole screen in panel coordinates. With loop set, step() continues with the first frame after the last.
+*/
+void MicroOLEDAnimation::begin(const uint8_t *animation, bool loop) {
+	this->animation = animation;
+	this->loop = loop;
+	frames = animation[0];
+	frame = 0;
+
+	oled.clear(PAGE);
+	second = deltaApply(animation + 1, oled.getScreenBuffer(), LCDWIDTH, LCDHEIGHT / 8);
+	next = second;
+	oled.display();
+}
+
+/** \brief Show next frame.
+
+    Apply the next delta frame and send only its changed windows. After the last frame the loop record brings the animation back to the first frame, or, without loop, nothing happens and false is returned.
+*/
+bool MicroOLEDAnimation::step(void) {
+	if ((animation == NULL) || (frames == 0))
+	return false;
+
+	if (frame + 1 >= frames) {		// next is the loop record
+		if (!loop)
+		return false;
+		apply(next);
+		next = second;
+		frame = 0;
+		return true;
+	}
+
+	next = apply(next);
+	frame++;
+	return true;
+}
+
+/** \brief Get frame.
+
+    Index of the frame shown last.
+*/
+uint8_t MicroOLEDAnimation::getFrame(void) {
+	return frame;
+}
+
+/** \brief Start playback.
+
+    Show the first frame with begin() and attach a ticker that advances one frame every period. The ticker only posts the frame to queue, which sends it from its dispatch context since SPI may not be used from an interrupt. A tick that comes while the previous frame is still pending is dropped, so a slow bus lowers the frame rate instead of piling up work. A non-looping animation stops after its last frame.
+*/
+void MicroOLEDAnimation::start(const uint8_t *animation, EventQueue &queue, std::chrono::microseconds period, bool loop) {
+	this->queue = &queue;
+	begin(animation, loop);
+	pending = false;
+	running = true;
+	ticker.attach(callback(this, &MicroOLEDAnimation::tick), period);
+}
+
+/** \brief Stop playback.
+
+    Detach the ticker; the current frame stays on the screen.
+*/
+void MicroOLEDAnimation::stop(void) {
+	ticker.detach();
+	running = false;
+}
+
+/** \brief Is playback running.
+
+    True from start() until stop() or the end of a non-looping animation.
+*/
+bool MicroOLEDAnimation::isRunning(void) {
+	return running;
+}
+
+/** \brief Ticker handler.
+
+    Post the next frame unless the previous one is still pending.
+*/
+void MicroOLEDAnimation::tick(void) {
+	if (pending || !running)
+	return;
+
+	pending = true;
+	if (queue->call(callback(this, &MicroOLEDAnimation::flushFrame)) == 0)
+	pending = false;			// queue full, the next tick retries
+}
+
+/** \brief Send frame.
+
+    Show the next frame from the event queue, stopping at the end of a non-looping animation.
+*/
+void MicroOLEDAnimation::flushFrame(void) {
+	pending = false;
+	if (running && !step())
+	stop();
+}
+
+/** \brief Apply record.
+
+    Copy each run of the delta frame record into the screen buffer and send its window. Runs outside the screen are skipped. Return a pointer just past the record.
+*/
+const uint8_t *MicroOLEDAnimation::apply(const uint8_t *record) {
+	uint8_t *screen = oled.getScreenBuffer();
+
+	while (*record != DELTA_END) {
+		uint8_t page = record[0], col = record[1], len = record[2];
+
+		record += 3;
+		if ((page < LCDHEIGHT / 8) && (col + len <= LCDWIDTH) && (len > 0)) {
+			memcpy(screen + page * LCDWIDTH + col, record, len);
+			oled.display(col, page * 8, len, 8);
+		}
+		record += len;
+	}
+	return record + 1;
+}
@@ -0,0 +1,62 @@
+/******************************************************************************
+SFE_MicroOLED_Animation.h
+Header file for the MicroOLED mbed Library animation player
+
+This file defines a player for animations in the delta frame format of
+SFE_MicroOLED_Delta.h. Each frame only writes the changed runs into the screen
+buffer and sends only those windows to the controller, and a ticker paces the
+frames, so bus traffic per frame follows how much of the picture changes.
+
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later
+version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#ifndef SFE_MICROOLED_ANIMATION_H
+#define SFE_MICROOLED_ANIMATION_H
+
+#include "SFE_MicroOLED.h"
+#include "SFE_MicroOLED_Delta.h"
+
+#ifdef MICROOLED_PAGEMODE
+#error "MicroOLEDAnimation needs the full screen buffer; not available with MICROOLED_PAGEMODE"
+#endif
+
+class MicroOLEDAnimation {
+public:
+	MicroOLEDAnimation(MicroOLED &oled);
+
+	void begin(const uint8_t *animation, bool loop = true);
+	bool step(void);
+	uint8_t getFrame(void);
+
+	void start(const uint8_t *animation, EventQueue &queue, std::chrono::microseconds period, bool loop = true);
+	void stop(void);
+	bool isRunning(void);
+
+private:
+	MicroOLED &oled;
+	const uint8_t *animation;
+	const uint8_t *next;		// record to apply by the next step()
+	const uint8_t *second;		// record of frame 1, where a loop continues
+	uint8_t frames, frame;
+	bool loop;
+
+	// Scheduler state; tick() runs in interrupt context and only posts flushFrame() to the queue
+	Ticker ticker;
+	EventQueue *queue;
+	volatile bool pending, running;
+	void tick(void);
+	void flushFrame(void);
+	const uint8_t *apply(const uint8_t *record);
+};
+#endif
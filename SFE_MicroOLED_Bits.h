@@ -0,0 +1,155 @@
+/******************************************************************************
+SFE_MicroOLED_Bits.h
+Bit matrix kernels for the MicroOLED mbed Library
+
+This file holds the 8x8 bit matrix helpers used to rotate images and to
+convert between row-major 1bpp images (XBM, PBM P4, BMP) and the page-major
+layout of the screen buffer, where one byte holds 8 vertical pixels. It only
+needs <stdint.h>, so host tools can include it to convert images offline with
+the same code the library runs on the device.
+
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later
+version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#ifndef SFE_MICROOLED_BITS_H
+#define SFE_MICROOLED_BITS_H
+
+#include <stdint.h>
+
+// Row-major 1bpp image formats: rows of (width + 7) / 8 bytes, top row first
+#define ROWMAJOR_LSBFIRST	0x00	// leftmost pixel of a byte in bit 0
+#define ROWMAJOR_MSBFIRST	0x01	// leftmost pixel of a byte in bit 7
+#define ROWMAJOR_INVERT		0x02	// 0 bits are lit pixels
+#define IMAGE_XBM			ROWMAJOR_LSBFIRST
+#define IMAGE_PBM			ROWMAJOR_MSBFIRST	// 1 = black ink drawn as lit pixels, add ROWMAJOR_INVERT for the opposite
+#define IMAGE_PAGEMAJOR		0x80	// screen buffer layout, see MicroOLED::blit()
+
+/** \brief Reverse byte order.
+
+    Reverse the order of the 8 bytes of x.
+*/
+static inline uint64_t reverseBytes(uint64_t x) {
+	x = (x >> 32) | (x << 32);
+	x = ((x >> 16) & 0x0000FFFF0000FFFFULL) | ((x & 0x0000FFFF0000FFFFULL) << 16);
+	x = ((x >> 8) & 0x00FF00FF00FF00FFULL) | ((x & 0x00FF00FF00FF00FFULL) << 8);
+	return x;
+}
+
+/** \brief Reverse bits of every byte.
+
+    Mirror the bit order of each of the 8 bytes of x, i.e. flip every page-major column upside down.
+*/
+static inline uint64_t reverseBits(uint64_t x) {
+	x = ((x >> 4) & 0x0F0F0F0F0F0F0F0FULL) | ((x & 0x0F0F0F0F0F0F0F0FULL) << 4);
+	x = ((x >> 2) & 0x3333333333333333ULL) | ((x & 0x3333333333333333ULL) << 2);
+	x = ((x >> 1) & 0x5555555555555555ULL) | ((x & 0x5555555555555555ULL) << 1);
+	return x;
+}
+
+/** \brief Transpose 8x8 bit matrix.
+
+    Byte i of x holds bits 0 to 7 of row i; return the transpose, so bit j of byte i becomes bit i of byte j. For a page-major block (byte i is column i, bit j is row j) this swaps rows and columns, and it turns 8 LSB-first row-major rows into 8 page-major columns. Three rounds of delta swaps (2x2, 4x4 then 8x8 sub-blocks) instead of 64 single-bit moves.
+*/
+static inline uint64_t transpose8(uint64_t x) {
+	uint64_t t;
+
+	t = (x ^ (x >> 7)) & 0x00AA00AA00AA00AAULL;
+	x ^= t ^ (t << 7);
+	t = (x ^ (x >> 14)) & 0x0000CCCC0000CCCCULL;
+	x ^= t ^ (t << 14);
+	t = (x ^ (x >> 28)) & 0x00000000F0F0F0F0ULL;
+	x ^= t ^ (t << 28);
+	return x;
+}
+
+/** \brief Gather an 8x8 block of a page-major image.
+
+    Return the 8x8 pixel block with top left corner col0,row0 of a width x height page-major image, one column per byte (col0 in the lowest byte, row0 in bit 0 of each). row0 need not be page aligned; pixels outside the image read as 0.
+*/
+static inline uint64_t gatherBlock(const uint8_t *image, uint8_t width, uint8_t height, int16_t col0, int16_t row0) {
+	int16_t page = row0 >> 3;		// floor, row0 may be negative
+	uint8_t shift = row0 & 7;
+	int16_t pages = (height + 7) / 8;
+	uint64_t block = 0;
+
+	for (uint8_t i = 0; i < 8; i++) {
+		int16_t col = col0 + i;
+		uint16_t bits = 0;
+
+		if ((col < 0) || (col >= width))
+		continue;
+		if ((page >= 0) && (page < pages))
+		bits = image[col + page * width];
+		if ((page + 1 >= 0) && (page + 1 < pages))
+		bits |= image[col + (page + 1) * width] << 8;
+		block |= (uint64_t)((bits >> shift) & 0xFF) << (i * 8);
+	}
+	return block;
+}
+
+/** \brief Gather one 8 pixel row segment of a row-major image.
+
+    Return pixels col0 to col0+7 of one row (bytes points at the row, bytesPerRow long) in ROWMAJOR_LSBFIRST order, col0 in bit 0. col0 need not be byte aligned; pixels outside the row read as 0 (before ROWMAJOR_INVERT).
+*/
+static inline uint8_t gatherRowSegment(const uint8_t *bytes, int16_t bytesPerRow, int16_t col0, uint8_t format) {
+	int16_t index = col0 >> 3;		// floor, col0 may be negative
+	uint8_t shift = col0 & 7;
+	uint16_t lo = ((index >= 0) && (index < bytesPerRow)) ? bytes[index] : 0;
+	uint16_t hi = ((index + 1 >= 0) && (index + 1 < bytesPerRow)) ? bytes[index + 1] : 0;
+
+	if (format & ROWMAJOR_MSBFIRST)	// big-endian bit window, reversed with the whole block later
+	return ((lo << 8) | hi) >> (8 - shift);
+	return (lo | (hi << 8)) >> shift;
+}
+
+/** \brief Gather an 8x8 block of a row-major image.
+
+    Return the 8x8 pixel block with top left corner col0,row0 of a width x height row-major image in format, converted to page-major: one column per byte (col0 in the lowest byte, row0 in bit 0 of each). The 8 row segments are packed into one word and turned into columns with a single transpose8(). Rows outside the image read as unlit.
+*/
+static inline uint64_t gatherRowBlock(const uint8_t *image, uint8_t width, uint8_t height, int16_t col0, int16_t row0, uint8_t format) {
+	int16_t bytesPerRow = (width + 7) / 8;
+	uint64_t block = 0, valid = 0;
+
+	for (uint8_t i = 0; i < 8; i++) {
+		int16_t row = row0 + i;
+
+		if ((row < 0) || (row >= height))
+		continue;
+		block |= (uint64_t)gatherRowSegment(image + row * bytesPerRow, bytesPerRow, col0, format) << (i * 8);
+		valid |= (uint64_t)0xFF << (i * 8);
+	}
+	if (format & ROWMAJOR_MSBFIRST)
+	block = reverseBits(block);
+	if (format & ROWMAJOR_INVERT)
+	block = ~block & valid;
+	return transpose8(block);
+}
+
+/** \brief Convert a row-major image to page-major.
+
+    Convert a width x height row-major image in format to the page-major layout of the screen buffer, width bytes per page and (height + 7) / 8 pages, 8x8 pixels at a time. Rows past height in the last page are left unlit. Usable on the device and in host tools.
+*/
+static inline void rowMajorToPageMajor(const uint8_t *src, uint8_t *dst, uint8_t width, uint8_t height, uint8_t format) {
+	for (int16_t page = 0; page < (height + 7) / 8; page++) {
+		for (int16_t col0 = 0; col0 < width; col0 += 8) {
+			uint64_t block = gatherRowBlock(src, width, height, col0, page * 8, format);
+
+			for (uint8_t i = 0; (i < 8) && (col0 + i < width); i++) {
+				dst[col0 + i + page * width] = block >> (i * 8);
+			}
+		}
+	}
+}
+
+#endif
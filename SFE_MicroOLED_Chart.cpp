@@ -0,0 +1,163 @@
+/****************************************************************************** 
+SFE_MicroOLED_Chart.cpp
+Strip chart for the MicroOLED mbed Library
+
+This file implements a strip chart that plots a live trace of samples. Each
+new sample shifts the plot by one column (or overwrites the oldest column in
+sweep mode) and only the plot area is sent to the display.
+
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software 
+Foundation, either version 3 of the License, or (at your option) any later 
+version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include "mbed.h"
+#include "SFE_MicroOLED_Chart.h"
+
+/** \brief Create strip chart.
+
+    The plot area is clipped to the screen. Samples are scaled so minValue is plotted at the bottom row and maxValue at the top row; values outside that range are clamped. Nothing is drawn until the first sample or redraw().
+*/
+MicroOLEDChart::MicroOLEDChart(MicroOLED &oled, uint8_t x, uint8_t page, uint8_t width, uint8_t pages, int16_t minValue, int16_t maxValue, uint8_t mode) : oled(oled), x(x), page(page), width(width), pages(pages), mode(mode), minValue(minValue), maxValue(maxValue)
+{
+	if (this->x >= LCDWIDTH) this->x = LCDWIDTH - 1;
+	if (this->page >= LCDHEIGHT / 8) this->page = (LCDHEIGHT / 8) - 1;
+	if (this->width > LCDWIDTH - this->x) this->width = LCDWIDTH - this->x;
+	if (this->pages > (LCDHEIGHT / 8) - this->page) this->pages = (LCDHEIGHT / 8) - this->page;
+	if (this->width == 0) this->width = 1;
+	if (this->pages == 0) this->pages = 1;
+	if (maxValue <= minValue) this->maxValue = minValue + 1;
+	head = 0;
+	count = 0;
+}
+
+/** \brief Add sample.
+
+    Plot value as a new column connected to the previous sample and send the change to the display.
+
+    CHART_SCROLL moves every page of the plot area one column left with memmove, draws the new column at the right edge and sends the plot area. CHART_SWEEP draws the new column over the oldest one and blanks the column after it as a moving gap, then sends just those two columns. The controller's own horizontal scroll cannot step by exactly one column, so sweep mode is the way to send a single column of new data per sample.
+*/
+void MicroOLEDChart::addSample(int16_t value) {
+	uint8_t *screen = oled.getScreenBuffer();
+	uint8_t row = valueToRow(value);
+	uint8_t prev = count ? rows[(head + width - 1) % width] : row;
+	uint8_t col;
+
+	if (mode == CHART_SWEEP) {
+		col = head;
+		if (col == 0)
+		prev = row;		// trace restarts at the left edge
+		drawColumn(col, prev, row);
+		if (col + 1 < width) {
+			clearColumn(col + 1);
+			oled.display(x + col, page * 8, 2, pages * 8);
+		}
+		else {
+			oled.display(x + col, page * 8, 1, pages * 8);
+		}
+	}
+	else {
+		for (uint8_t p = page; p < page + pages; p++) {
+			memmove(screen + p * LCDWIDTH + x, screen + p * LCDWIDTH + x + 1, width - 1);
+		}
+		drawColumn(width - 1, prev, row);
+		oled.display(x, page * 8, width, pages * 8);
+	}
+
+	rows[head] = row;
+	head = (head + 1) % width;
+	if (count < width)
+	count++;
+}
+
+/** \brief Clear strip chart.
+
+    Forget all samples and blank the plot area on the display.
+*/
+void MicroOLEDChart::clear(void) {
+	head = 0;
+	count = 0;
+	redraw();
+}
+
+/** \brief Redraw strip chart.
+
+    Draw the whole plot area from the stored samples and send it, e.g. after something else has drawn over it.
+*/
+void MicroOLEDChart::redraw(void) {
+	uint8_t col, index, prev;
+
+	for (col = 0; col < width; col++) {
+		clearColumn(col);
+	}
+
+	if (mode == CHART_SWEEP) {
+		for (col = 0; col < count; col++) {
+			if (col == head)	// the gap in front of the newest sample
+			continue;
+			prev = ((col == 0) || (col == (head + 1) % width)) ? rows[col] : rows[col - 1];
+			drawColumn(col, prev, rows[col]);
+		}
+	}
+	else {
+		index = (head + width - count) % width;	// oldest sample
+		prev = rows[index];
+		for (col = width - count; col < width; col++) {
+			drawColumn(col, prev, rows[index]);
+			prev = rows[index];
+			index = (index + 1) % width;
+		}
+	}
+	oled.display(x, page * 8, width, pages * 8);
+}
+
+/** \brief Scale value to a plot row.
+
+    Return the row, counted from the top of the plot area, value is plotted at.
+*/
+uint8_t MicroOLEDChart::valueToRow(int16_t value) {
+	int32_t span = (int32_t)maxValue - minValue;
+	uint8_t height = pages * 8;
+
+	if (value < minValue) value = minValue;
+	if (value > maxValue) value = maxValue;
+	return (height - 1) - (((int32_t)value - minValue) * (height - 1) + span / 2) / span;
+}
+
+/** \brief Draw a plot column.
+
+    Replace column col of the plot area with a vertical segment between rows row0 and row1 (either order), built as one word and stored a page byte at a time.
+*/
+void MicroOLEDChart::drawColumn(uint8_t col, uint8_t row0, uint8_t row1) {
+	uint8_t *p = oled.getScreenBuffer() + x + col + page * LCDWIDTH;
+	uint64_t bits;
+
+	if (row0 > row1) {
+		uint8_t t = row0;
+		row0 = row1;
+		row1 = t;
+	}
+	bits = ((((uint64_t)1 << (row1 - row0 + 1)) - 1) << row0);
+	for (uint8_t i = 0; i < pages; i++, p += LCDWIDTH) {
+		*p = bits >> (i * 8);
+	}
+}
+
+/** \brief Blank a plot column.
+*/
+void MicroOLEDChart::clearColumn(uint8_t col) {
+	uint8_t *p = oled.getScreenBuffer() + x + col + page * LCDWIDTH;
+
+	for (uint8_t i = 0; i < pages; i++, p += LCDWIDTH) {
+		*p = 0;
+	}
+}
@@ -0,0 +1,56 @@
+/****************************************************************************** 
+SFE_MicroOLED_Chart.h
+Header file for the MicroOLED mbed Library strip chart
+
+This file defines a strip chart that plots a live trace of samples. Each new
+sample shifts the plot by one column (or overwrites the oldest column in
+sweep mode) and only the plot area is sent to the display.
+
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software 
+Foundation, either version 3 of the License, or (at your option) any later 
+version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#ifndef SFE_MICROOLED_CHART_H
+#define SFE_MICROOLED_CHART_H
+
+#include "SFE_MicroOLED.h"
+
+#ifdef MICROOLED_PAGEMODE
+#error "MicroOLEDChart needs the full screen buffer; not available with MICROOLED_PAGEMODE"
+#endif
+
+#define CHART_SCROLL		0	// plot shifts left, newest sample at the right edge
+#define CHART_SWEEP			1	// newest sample overwrites the oldest column, like an oscilloscope sweep
+
+class MicroOLEDChart {
+public:
+	// Plot area is width columns from x, pages display pages (8 rows each) from page
+	MicroOLEDChart(MicroOLED &oled, uint8_t x, uint8_t page, uint8_t width, uint8_t pages, int16_t minValue, int16_t maxValue, uint8_t mode = CHART_SCROLL);
+
+	void addSample(int16_t value);
+	void clear(void);
+	void redraw(void);
+
+private:
+	MicroOLED &oled;
+	uint8_t x, page, width, pages, mode;
+	int16_t minValue, maxValue;
+	uint8_t rows[LCDWIDTH];	// plotted row of every sample, ring buffer
+	uint8_t head;			// ring index the next sample goes to
+	uint8_t count;			// samples in the ring
+
+	uint8_t valueToRow(int16_t value);
+	void drawColumn(uint8_t col, uint8_t row0, uint8_t row1);
+	void clearColumn(uint8_t col);
+};
+#endif
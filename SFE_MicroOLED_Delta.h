@@ -0,0 +1,93 @@
+/******************************************************************************
+SFE_MicroOLED_Delta.h
+Delta frame format for the MicroOLED mbed Library
+
+This file defines an animation format that stores only what changes between
+page-major frames. A frame record is a list of runs, each a page byte, a start
+column byte and a length byte followed by that many new screen bytes, and
+ends with the page byte DELTA_END. Runs never cross a page, so every run is
+one address window on the controller. An animation is a frame count byte N
+followed by N + 1 records: the first frame against a blank screen, the
+changes to each further frame, and the changes from the last frame back to
+the first for looping. The encoder and decoder only need <stdint.h>, so host
+tools use the same code as the device.
+
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later
+version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#ifndef SFE_MICROOLED_DELTA_H
+#define SFE_MICROOLED_DELTA_H
+
+#include <stdint.h>
+
+#define DELTA_END		0xFF	// page byte that ends a frame record
+#define DELTA_MAXGAP	3		// unchanged bytes that are cheaper to resend than a new 3 byte run header
+#define DELTA_MAXSIZE(width, pages)	(((width) + 3) * (pages) + 1)	// worst case record size
+
+/** \brief Encode delta frame.
+
+    Write the record that turns the width x pages page-major frame prev into cur to dst, which must hold DELTA_MAXSIZE(width, pages) bytes. Changed bytes of a page separated by up to DELTA_MAXGAP unchanged ones share a run. Return the record size.
+*/
+static inline uint16_t deltaEncode(const uint8_t *prev, const uint8_t *cur, uint8_t width, uint8_t pages, uint8_t *dst) {
+	uint16_t out = 0;
+
+	for (uint8_t page = 0; page < pages; page++) {
+		const uint8_t *p = prev + page * width, *c = cur + page * width;
+		uint16_t x = 0;
+
+		while (x < width) {
+			if (c[x] == p[x]) {
+				x++;
+				continue;
+			}
+
+			uint16_t start = x, end = x + 1;	// end is exclusive
+			for (uint16_t i = x + 1; (i < width) && (i - end <= DELTA_MAXGAP); i++) {
+				if (c[i] != p[i])
+				end = i + 1;
+			}
+
+			dst[out++] = page;
+			dst[out++] = start;
+			dst[out++] = end - start;
+			for (uint16_t i = start; i < end; i++) {
+				dst[out++] = c[i];
+			}
+			x = end;
+		}
+	}
+	dst[out++] = DELTA_END;
+	return out;
+}
+
+/** \brief Apply delta frame.
+
+    Copy the runs of the record at src into the width x pages page-major frame dst. Runs outside the frame are skipped. Return a pointer just past the record, i.e. to the next frame record.
+*/
+static inline const uint8_t *deltaApply(const uint8_t *src, uint8_t *dst, uint8_t width, uint8_t pages) {
+	while (*src != DELTA_END) {
+		uint8_t page = src[0], col = src[1], len = src[2];
+
+		src += 3;
+		if ((page < pages) && (col + len <= width)) {
+			for (uint8_t i = 0; i < len; i++) {
+				dst[page * width + col + i] = src[i];
+			}
+		}
+		src += len;
+	}
+	return src + 1;
+}
+
+#endif
@@ -0,0 +1,210 @@
+/******************************************************************************
+SFE_MicroOLED_Dither.cpp
+Dithering engine for the MicroOLED mbed Library
+
+This file implements grayscale to 1bpp conversion into the page-major layout of
+the screen buffer: Bayer ordered dithering from a threshold table, and
+Floyd-Steinberg and Atkinson error diffusion with streaming row error buffers.
+
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later
+version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include "mbed.h"
+#include "SFE_MicroOLED_Dither.h"
+
+// 8x8 Bayer matrix scaled to gray levels: a pixel is lit if its gray value is above the threshold
+static const uint8_t bayerThreshold[8][8] = {
+	{  2, 130,  34, 162,  10, 138,  42, 170 },
+	{194,  66, 226,  98, 202,  74, 234, 106 },
+	{ 50, 178,  18, 146,  58, 186,  26, 154 },
+	{242, 114, 210,  82, 250, 122, 218,  90 },
+	{ 14, 142,  46, 174,   6, 134,  38, 166 },
+	{206,  78, 238, 110, 198,  70, 230, 102 },
+	{ 62, 190,  30, 158,  54, 182,  22, 150 },
+	{254, 126, 222,  94, 246, 118, 214,  86 },
+};
+
+/** \brief Create dithering engine.
+
+    method is DITHER_BAYER, DITHER_FLOYDSTEINBERG or DITHER_ATKINSON.
+*/
+MicroOLEDDither::MicroOLEDDither(uint8_t method) : method(method)
+{
+	dst = NULL;
+	width = 0;
+	height = 0;
+	row = 0;
+	current = 0;
+}
+
+/** \brief Set dithering method.
+
+    Select DITHER_BAYER, DITHER_FLOYDSTEINBERG or DITHER_ATKINSON for the next image.
+*/
+void MicroOLEDDither::setMethod(uint8_t method) {
+	this->method = method;
+}
+
+/** \brief Start image.
+
+    Start converting a width x height image into dst, a page-major buffer width bytes wide with (height + 7) / 8 pages (the screen buffer itself for a LCDWIDTH x LCDHEIGHT image, or a bitmap for blit()). Rows are then passed to addRow() top to bottom. Error diffusion is limited to MAXDITHERWIDTH columns, wider images are cut.
+*/
+void MicroOLEDDither::begin(uint8_t *dst, uint8_t width, uint8_t height) {
+	this->dst = dst;
+	this->width = width;
+	this->height = height;
+	row = 0;
+	current = 0;
+	memset(error, 0, sizeof(error));
+}
+
+/** \brief Add row.
+
+    Dither the next row of the image, width gray values (0 black to 255 white), into the destination buffer. Return false once all rows of the image have been added.
+*/
+bool MicroOLEDDither::addRow(const uint8_t *gray) {
+	if ((dst == NULL) || (row >= height))
+	return false;
+
+	switch (method) {
+		case DITHER_FLOYDSTEINBERG:	floydSteinbergRow(gray);	break;
+		case DITHER_ATKINSON:		atkinsonRow(gray);			break;
+		default:					bayerRow(gray);				break;
+	}
+	row++;
+	return true;
+}
+
+/** \brief Convert image.
+
+    Dither a whole width x height grayscale image (rows top to bottom, width bytes each) into the page-major buffer dst. Bayer dithering takes a fast path here: each output byte is built from 8 rows at once by comparing against a row of the threshold table, so no byte is read back and the inner loop over columns has no branches (host compilers vectorise it). Error diffusion feeds the rows to addRow().
+*/
+void MicroOLEDDither::convert(const uint8_t *gray, uint8_t *dst, uint8_t width, uint8_t height) {
+	if (method != DITHER_BAYER) {
+		begin(dst, width, height);
+		for (uint8_t y = 0; y < height; y++) {
+			addRow(gray + y * width);
+		}
+		return;
+	}
+
+	for (uint8_t page = 0; page < (height + 7) / 8; page++) {
+		uint8_t *out = dst + page * width;
+		uint8_t rows = (height - page * 8 < 8) ? height - page * 8 : 8;
+
+		memset(out, 0, width);
+		for (uint8_t r = 0; r < rows; r++) {
+			const uint8_t *in = gray + (page * 8 + r) * width;
+			const uint8_t *threshold = bayerThreshold[r];	// page * 8 + r has the same row of the 8x8 matrix
+
+			int x = 0;
+
+			for (; x + 8 <= width; x += 8) {	// 8 columns per threshold row
+				for (int k = 0; k < 8; k++) {
+					out[x + k] |= (uint8_t)(in[x + k] > threshold[k]) << r;
+				}
+			}
+			for (; x < width; x++) {
+				out[x] |= (uint8_t)(in[x] > threshold[x & 7]) << r;
+			}
+		}
+	}
+}
+
+/** \brief Bayer dither row.
+
+    Set or clear the pixels of the current row by comparing each gray value with its threshold.
+*/
+void MicroOLEDDither::bayerRow(const uint8_t *gray) {
+	uint8_t *out = dst + (row >> 3) * width;
+	uint8_t bit = 1 << (row & 7);
+	const uint8_t *threshold = bayerThreshold[row & 7];
+
+	for (uint8_t x = 0; x < width; x++) {
+		if (gray[x] > threshold[x & 7])
+		out[x] |= bit;
+		else
+		out[x] &= ~bit;
+	}
+}
+
+/** \brief Floyd-Steinberg dither row.
+
+    Quantise the current row and spread the error 7/16 right, 3/16 down left, 5/16 down and 1/16 down right. A single error row is used: error[current][x + 1] holds the error for column x of this row until column x is done, then the error for column x of the next row. The down right share waits in a variable until the next column has been read.
+*/
+void MicroOLEDDither::floydSteinbergRow(const uint8_t *gray) {
+	uint8_t *out = dst + (row >> 3) * width;
+	uint8_t bit = 1 << (row & 7);
+	int16_t *err = error[0];
+	int16_t right = 0, downRight = 0;
+	uint8_t columns = (width < MAXDITHERWIDTH) ? width : MAXDITHERWIDTH;
+
+	for (uint8_t x = 0; x < columns; x++) {
+		int16_t v = gray[x] + err[x + 1] + right;
+		int16_t e;
+
+		if (v > 127) {
+			out[x] |= bit;
+			e = v - 255;
+		}
+		else {
+			out[x] &= ~bit;
+			e = v;
+		}
+
+		err[x] += e * 3 / 16;		// next row, column x - 1 (err[0] is a dump slot)
+		err[x + 1] = e * 5 / 16 + downRight;
+		downRight = e / 16;
+		right = e * 7 / 16;
+	}
+	err[0] = 0;
+}
+
+/** \brief Atkinson dither row.
+
+    Quantise the current row and spread 1/8 of the error to each of the next two columns, the three columns below and the column two rows down (3/4 in total, the rest is dropped for more contrast). The current row's error buffer is reused for the row two down once a column has been read, so two error rows are enough.
+*/
+void MicroOLEDDither::atkinsonRow(const uint8_t *gray) {
+	uint8_t *out = dst + (row >> 3) * width;
+	uint8_t bit = 1 << (row & 7);
+	int16_t *cur = error[current], *next = error[current ^ 1];
+	int16_t right1 = 0, right2 = 0;
+	uint8_t columns = (width < MAXDITHERWIDTH) ? width : MAXDITHERWIDTH;
+
+	for (uint8_t x = 0; x < columns; x++) {
+		int16_t v = gray[x] + cur[x + 1] + right1;
+		int16_t e;
+
+		if (v > 127) {
+			out[x] |= bit;
+			e = (v - 255) / 8;
+		}
+		else {
+			out[x] &= ~bit;
+			e = v / 8;
+		}
+
+		right1 = right2 + e;
+		right2 = e;
+		cur[x + 1] = e;				// two rows down
+		next[x] += e;				// next row, columns x - 1 to x + 1
+		next[x + 1] += e;
+		next[x + 2] += e;
+	}
+	next[0] = 0;					// dump slots left and right of the image
+	next[columns + 1] = 0;
+	cur[0] = 0;
+	cur[columns + 1] = 0;
+	current ^= 1;
+}
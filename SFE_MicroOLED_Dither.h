@@ -0,0 +1,55 @@
+/******************************************************************************
+SFE_MicroOLED_Dither.h
+Header file for the MicroOLED mbed Library dithering engine
+
+This file defines a converter from 8-bit grayscale images to the page-major
+1bpp layout of the screen buffer, with Bayer ordered dithering or
+Floyd-Steinberg / Atkinson error diffusion. Rows can be fed one at a time, so
+images streamed from a camera or a file need no full grayscale copy.
+
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later
+version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#ifndef SFE_MICROOLED_DITHER_H
+#define SFE_MICROOLED_DITHER_H
+
+#include "SFE_MicroOLED.h"
+
+#define DITHER_BAYER			0	// 8x8 ordered dither, no state between pixels
+#define DITHER_FLOYDSTEINBERG	1	// error diffusion to 4 neighbours
+#define DITHER_ATKINSON			2	// error diffusion of 3/4 of the error to 6 neighbours, higher contrast
+
+#define MAXDITHERWIDTH		128		// Widest image error diffusion can handle, sets the error buffer size
+
+class MicroOLEDDither {
+public:
+	MicroOLEDDither(uint8_t method = DITHER_BAYER);
+
+	void begin(uint8_t *dst, uint8_t width, uint8_t height);
+	bool addRow(const uint8_t *gray);
+	void convert(const uint8_t *gray, uint8_t *dst, uint8_t width, uint8_t height);
+	void setMethod(uint8_t method);
+
+private:
+	uint8_t method;
+	uint8_t *dst;
+	uint8_t width, height, row;
+	int16_t error[2][MAXDITHERWIDTH + 2];	// diffused error per column (index x + 1), current and next row
+	uint8_t current;						// error[] row that holds the current row
+
+	void bayerRow(const uint8_t *gray);
+	void floydSteinbergRow(const uint8_t *gray);
+	void atkinsonRow(const uint8_t *gray);
+};
+#endif
@@ -0,0 +1,203 @@
+/******************************************************************************
+SFE_MicroOLED_Gray.cpp
+Grayscale mode for the MicroOLED mbed Library
+
+This file implements a 4-level grayscale frame buffer made of two bit-planes.
+A ticker splits each frame into slots; the more significant plane is shown for
+two slots and the other for one, and a plane is only sent when the plane to
+show changes.
+
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later
+version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include "mbed.h"
+#include "SFE_MicroOLED_Gray.h"
+
+/** \brief Create grayscale frame buffer.
+
+    levels is 2 or 4; with 4 levels, level 0 is off, 1 and 2 are dark and light gray, 3 is fully lit. The planes start cleared and nothing is shown until start().
+*/
+MicroOLEDGray::MicroOLEDGray(MicroOLED &oled, uint8_t levels) : oled(oled)
+{
+	planes = (levels > 2) ? 2 : 1;
+	queue = NULL;
+	slot = 0;
+	wanted = 0;
+	shown = 0;
+	pending = false;
+	running = false;
+	clear();
+}
+
+/** \brief Clear planes.
+
+    Set every pixel to level 0.
+*/
+void MicroOLEDGray::clear(void) {
+	memset(plane, 0, sizeof(plane));
+}
+
+/** \brief Set pixel level.
+
+    Set pixel x,y (panel coordinates) to level. Pixels outside the screen are ignored.
+*/
+void MicroOLEDGray::pixel(int16_t x, int16_t y, uint8_t level) {
+	if ((x<0) || (y<0) || (x>=LCDWIDTH) || (y>=LCDHEIGHT))
+	return;
+
+	uint16_t i = x + (y >> 3) * LCDWIDTH;
+	uint8_t bit = 1 << (y & 7);
+
+	for (uint8_t p = 0; p < planes; p++) {
+		if (level & (1 << p))
+		plane[p][i] |= bit;
+		else
+		plane[p][i] &= ~bit;
+	}
+}
+
+/** \brief Fill rectangle with level.
+
+    Set the width x height rectangle at x,y (panel coordinates) to level, clipped to the screen, a page byte at a time in every plane.
+*/
+void MicroOLEDGray::rectFill(int16_t x, int16_t y, uint8_t width, uint8_t height, uint8_t level) {
+	int16_t x1 = x + width, y1 = y + height;	// exclusive
+
+	if (x < 0) x = 0;
+	if (y < 0) y = 0;
+	if (x1 > LCDWIDTH) x1 = LCDWIDTH;
+	if (y1 > LCDHEIGHT) y1 = LCDHEIGHT;
+	if ((x >= x1) || (y >= y1))
+	return;
+
+	for (uint8_t page = y >> 3; page <= (y1 - 1) >> 3; page++) {
+		uint8_t mask = 0xFF;
+
+		if (page == (y >> 3))
+		mask &= 0xFF << (y & 7);
+		if (page == ((y1 - 1) >> 3))
+		mask &= 0xFF >> (7 - ((y1 - 1) & 7));
+
+		for (uint8_t p = 0; p < planes; p++) {
+			uint8_t *b = plane[p] + page * LCDWIDTH;
+			uint8_t set = (level & (1 << p)) ? mask : 0;
+
+			for (int16_t col = x; col < x1; col++) {
+				b[col] = (b[col] & ~mask) | set;
+			}
+		}
+	}
+}
+
+/** \brief Set level from screen buffer.
+
+    Set every pixel that is lit in the MicroOLED screen buffer to level, leaving the others unchanged. This way anything the normal drawing functions can draw (text, circles, polygons, with clipping and rotation) becomes a gray layer: draw it, call setFromScreen(), clear the screen buffer and draw the next level.
+*/
+void MicroOLEDGray::setFromScreen(uint8_t level) {
+	const uint8_t *screen = oled.getScreenBuffer();
+
+	for (uint8_t p = 0; p < planes; p++) {
+		uint8_t *b = plane[p];
+		bool set = level & (1 << p);
+
+		for (uint16_t i = 0; i < LCDWIDTH * LCDHEIGHT / 8; i++) {
+			b[i] = set ? (b[i] | screen[i]) : (b[i] & ~screen[i]);
+		}
+	}
+}
+
+/** \brief Get pixel level.
+
+    Level of pixel x,y (panel coordinates), 0 outside the screen.
+*/
+uint8_t MicroOLEDGray::getPixel(int16_t x, int16_t y) {
+	uint8_t level = 0;
+
+	if ((x<0) || (y<0) || (x>=LCDWIDTH) || (y>=LCDHEIGHT))
+	return 0;
+
+	for (uint8_t p = 0; p < planes; p++) {
+		if (plane[p][x + (y >> 3) * LCDWIDTH] & (1 << (y & 7)))
+		level |= 1 << p;
+	}
+	return level;
+}
+
+/** \brief Get bit-plane.
+
+    The page-major buffer of plane (0 is the least significant), e.g. for blit() style direct writes. NULL if there is no such plane.
+*/
+uint8_t *MicroOLEDGray::getPlane(uint8_t plane) {
+	if (plane >= planes)
+	return NULL;
+	return this->plane[plane];
+}
+
+/** \brief Start showing gray levels.
+
+    Attach a ticker firing every slot. Per frame of GRAYSLOTS slots, plane 1 is shown for two slots and plane 0 for one, so the levels average to 0, 1/3, 2/3 and full brightness. The ticker only picks the plane; the flush is posted to queue and runs in its dispatch context, since SPI may not be used from an interrupt. A plane is sent only when it differs from the one on the panel, i.e. twice per frame with 4 levels and once in total with 2 (the ticker then only retries a flush the queue had no room for). Slots of 2-5 ms (a frame rate of 65-170 Hz) avoid visible flicker when a full frame takes well under a slot to send.
+*/
+void MicroOLEDGray::start(EventQueue &queue, std::chrono::microseconds slot) {
+	this->queue = &queue;
+	this->slot = 0;
+	wanted = planes - 1;
+	shown = MAXGRAYPLANES;		// no plane on the panel yet
+	running = true;
+	pending = true;
+	if (queue.call(callback(this, &MicroOLEDGray::flushPlane)) == 0)
+	pending = false;			// queue full, the next tick retries
+
+	ticker.attach(callback(this, &MicroOLEDGray::tick), slot);
+}
+
+/** \brief Stop showing gray levels.
+
+    Detach the ticker. A flush that is already queued does nothing, so the panel keeps the plane it shows last; call display() to show the screen buffer again.
+*/
+void MicroOLEDGray::stop(void) {
+	ticker.detach();
+	running = false;
+}
+
+/** \brief Ticker handler.
+
+    Advance to the next slot and post a flush if the slot shows another plane than the panel. A slot whose flush is still pending is skipped rather than queued behind it, and a flush the queue had no room for is retried on a later slot.
+*/
+void MicroOLEDGray::tick(void) {
+	uint8_t want;
+
+	slot = (slot + 1) % GRAYSLOTS;
+	want = ((planes > 1) && (slot < 2)) ? 1 : 0;
+	if ((want == shown) || pending)
+	return;
+
+	wanted = want;
+	pending = true;
+	if (queue->call(callback(this, &MicroOLEDGray::flushPlane)) == 0)
+	pending = false;			// queue full, the next tick retries
+}
+
+/** \brief Send plane.
+
+    Send the plane chosen by tick() to the panel, from the event queue. Nothing is sent once stop() has been called.
+*/
+void MicroOLEDGray::flushPlane(void) {
+	uint8_t p = wanted;
+
+	if (running) {
+		oled.displayFrame(plane[p]);
+		shown = p;
+	}
+	pending = false;
+}
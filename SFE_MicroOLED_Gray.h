@@ -0,0 +1,63 @@
+/******************************************************************************
+SFE_MicroOLED_Gray.h
+Header file for the MicroOLED mbed Library grayscale mode
+
+This file defines a grayscale frame buffer for the 1-bit panel. Gray levels
+are stored as bit-planes, and a ticker shows the planes in turn for weighted
+times (frame PWM), so the eye averages them into gray.
+
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later
+version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#ifndef SFE_MICROOLED_GRAY_H
+#define SFE_MICROOLED_GRAY_H
+
+#include "SFE_MicroOLED.h"
+
+#ifdef MICROOLED_PAGEMODE
+#error "MicroOLEDGray needs the full screen buffer; not available with MICROOLED_PAGEMODE"
+#endif
+
+#define MAXGRAYPLANES		2		// 4 gray levels
+#define GRAYSLOTS			3		// ticker slots per frame: plane 1 shown for 2, plane 0 for 1
+
+class MicroOLEDGray {
+public:
+	// levels is 2 (one plane, plain monochrome) or 4 (two planes weighted 2:1)
+	MicroOLEDGray(MicroOLED &oled, uint8_t levels = 4);
+
+	void clear(void);
+	void pixel(int16_t x, int16_t y, uint8_t level);
+	void rectFill(int16_t x, int16_t y, uint8_t width, uint8_t height, uint8_t level);
+	void setFromScreen(uint8_t level);
+	uint8_t getPixel(int16_t x, int16_t y);
+	uint8_t *getPlane(uint8_t plane);
+
+	void start(EventQueue &queue, std::chrono::microseconds slot);
+	void stop(void);
+
+private:
+	MicroOLED &oled;
+	uint8_t planes;
+	uint8_t plane[MAXGRAYPLANES][LCDWIDTH * LCDHEIGHT / 8];
+
+	// Scheduler state; tick() runs in interrupt context and only posts flushPlane() to the queue
+	Ticker ticker;
+	EventQueue *queue;
+	volatile uint8_t slot, wanted, shown;
+	volatile bool pending, running;
+	void tick(void);
+	void flushPlane(void);
+};
+#endif
@@ -0,0 +1,248 @@
+/******************************************************************************
+SFE_MicroOLED_Image.cpp
+Image decoder for the MicroOLED mbed Library
+
+This file implements a streaming decoder for 1bpp PBM (P4) and BMP images. It
+reads the file through a small chunk buffer, collects 8 rows at a time and
+hands each strip to the row-major blit, which transposes it straight into the
+screen buffer.
+
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later
+version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include "mbed.h"
+#include "SFE_MicroOLED_Image.h"
+
+/** \brief Create image decoder.
+
+    The decoder draws into the screen buffer of oled. It holds one chunk of the file and one 8 row strip of the image, nothing else.
+*/
+MicroOLEDImage::MicroOLEDImage(MicroOLED &oled) : oled(oled)
+{
+	file = NULL;
+	chunkPos = 0;
+	chunkLen = 0;
+	width = 0;
+	height = 0;
+}
+
+/** \brief Draw image.
+
+    Decode the PBM (P4) or BMP image at the current position of file and draw it with its top left corner at x,y using raster operation rop, through blitRowMajor() so viewport, clip rectangle and rotation apply. BMP images must be uncompressed 1bpp; the palette decides which bit value is lit. In PBM images 1 bits (black ink) are lit. The file is read sequentially and never seeked, so any stream works. Call display() afterwards to show the image.
+
+    Return IMAGE_OK, or IMAGE_ERROR_READ, IMAGE_ERROR_FORMAT or IMAGE_ERROR_SIZE. Strips decoded before an error stay drawn.
+*/
+int8_t MicroOLEDImage::draw(FileHandle &file, int16_t x, int16_t y, uint8_t rop) {
+	uint8_t magic[2];
+
+	this->file = &file;
+	chunkPos = 0;
+	chunkLen = 0;
+	width = 0;
+	height = 0;
+
+	if (!readBytes(magic, 2))
+	return IMAGE_ERROR_READ;
+	if ((magic[0] == 'P') && (magic[1] == '4'))
+	return drawPBM(x, y, rop);
+	if ((magic[0] == 'B') && (magic[1] == 'M'))
+	return drawBMP(x, y, rop);
+	return IMAGE_ERROR_FORMAT;
+}
+
+/** \brief Get image width.
+
+    Width in pixels of the last image passed to draw(), 0 if its header could not be read.
+*/
+uint16_t MicroOLEDImage::getWidth(void) {
+	return width;
+}
+
+/** \brief Get image height.
+
+    Height in pixels of the last image passed to draw(), 0 if its header could not be read.
+*/
+uint16_t MicroOLEDImage::getHeight(void) {
+	return height;
+}
+
+/** \brief Read byte.
+
+    Next byte of the file, refilling the chunk buffer as needed. Return -1 at the end of the file or on a read error.
+*/
+int16_t MicroOLEDImage::readByte(void) {
+	if (chunkPos == chunkLen) {
+		ssize_t n = file->read(chunk, IMAGECHUNKSIZE);
+		if (n <= 0)
+		return -1;
+		chunkPos = 0;
+		chunkLen = n;
+	}
+	return chunk[chunkPos++];
+}
+
+/** \brief Read bytes.
+
+    Copy the next len bytes of the file to dst, or skip them if dst is NULL. Return false if the file ends first.
+*/
+bool MicroOLEDImage::readBytes(uint8_t *dst, uint32_t len) {
+	while (len > 0) {
+		if (chunkPos == chunkLen) {
+			ssize_t n = file->read(chunk, IMAGECHUNKSIZE);
+			if (n <= 0)
+			return false;
+			chunkPos = 0;
+			chunkLen = n;
+		}
+
+		uint8_t n = chunkLen - chunkPos;
+		if (n > len) n = len;
+		if (dst) {
+			memcpy(dst, chunk + chunkPos, n);
+			dst += n;
+		}
+		chunkPos += n;
+		len -= n;
+	}
+	return true;
+}
+
+/** \brief Read little-endian number.
+
+    Read an unsigned little-endian number of 1 to 4 bytes into value. Return false if the file ends first.
+*/
+bool MicroOLEDImage::readLE(uint32_t &value, uint8_t bytes) {
+	uint8_t buf[4];
+
+	if (!readBytes(buf, bytes))
+	return false;
+
+	value = 0;
+	for (uint8_t i = bytes; i > 0; i--) {
+		value = (value << 8) | buf[i - 1];
+	}
+	return true;
+}
+
+/** \brief Read PBM header number.
+
+    Skip whitespace and # comments, then read a decimal number and the single whitespace character that ends it. Return false on a malformed header.
+*/
+bool MicroOLEDImage::readNumber(uint16_t &value) {
+	int16_t c = readByte();
+	uint32_t n = 0;
+
+	while ((c == ' ') || (c == '\t') || (c == '\r') || (c == '\n') || (c == '#')) {
+		if (c == '#') {		// comment runs to the end of the line
+			while ((c != '\n') && (c >= 0)) c = readByte();
+		}
+		c = readByte();
+	}
+	if ((c < '0') || (c > '9'))
+	return false;
+
+	while ((c >= '0') && (c <= '9')) {
+		n = n * 10 + (c - '0');
+		if (n > 0xFFFF)
+		return false;
+		c = readByte();
+	}
+	if ((c != ' ') && (c != '\t') && (c != '\r') && (c != '\n'))
+	return false;
+
+	value = n;
+	return true;
+}
+
+/** \brief Draw PBM image.
+
+    Parse the rest of a P4 header, then decode the raster: rows of (width + 7) / 8 bytes, MSB first, top row first.
+*/
+int8_t MicroOLEDImage::drawPBM(int16_t x, int16_t y, uint8_t rop) {
+	if (!readNumber(width) || !readNumber(height))
+	return IMAGE_ERROR_FORMAT;
+
+	return drawRows(x, y, 0, IMAGE_PBM, false, rop);
+}
+
+/** \brief Draw BMP image.
+
+    Parse the rest of the file header and a BITMAPINFOHEADER (or a later, longer version), read the first two palette entries and skip to the pixel data: rows padded to 4 bytes, MSB first, bottom row first unless the height is negative.
+*/
+int8_t MicroOLEDImage::drawBMP(int16_t x, int16_t y, uint8_t rop) {
+	uint32_t dataOffset, headerSize, w, h, planes, bpp, compression, consumed;
+	uint8_t palette[8];
+	bool bottomUp = true;
+
+	if (!readBytes(NULL, 8) || !readLE(dataOffset, 4) || !readLE(headerSize, 4))
+	return IMAGE_ERROR_READ;
+	if (headerSize < 40)		// BITMAPCOREHEADER and other old variants are not supported
+	return IMAGE_ERROR_FORMAT;
+	if (!readLE(w, 4) || !readLE(h, 4) || !readLE(planes, 2) || !readLE(bpp, 2) || !readLE(compression, 4))
+	return IMAGE_ERROR_READ;
+	if ((planes != 1) || (bpp != 1) || (compression != 0))
+	return IMAGE_ERROR_FORMAT;
+
+	// rest of the info header, then the two palette entries (blue, green, red, reserved)
+	if (!readBytes(NULL, headerSize - 20) || !readBytes(palette, 8))
+	return IMAGE_ERROR_READ;
+	consumed = 14 + headerSize + 8;
+	if (dataOffset < consumed)
+	return IMAGE_ERROR_FORMAT;
+	if (!readBytes(NULL, dataOffset - consumed))
+	return IMAGE_ERROR_READ;
+
+	if ((int32_t)h < 0) {		// top-down bitmap
+		h = -(int32_t)h;
+		bottomUp = false;
+	}
+	if (((int32_t)w <= 0) || (w > 0xFFFF) || (h > 0xFFFF))
+	return IMAGE_ERROR_SIZE;
+	width = w;
+	height = h;
+
+	// the brighter palette entry is lit
+	uint16_t luma0 = palette[0] + 5 * palette[1] + 2 * palette[2];
+	uint16_t luma1 = palette[4] + 5 * palette[5] + 2 * palette[6];
+	uint8_t format = ROWMAJOR_MSBFIRST | ((luma1 > luma0) ? 0 : ROWMAJOR_INVERT);
+
+	return drawRows(x, y, ((width + 31) / 32) * 4 - (width + 7) / 8, format, bottomUp, rop);
+}
+
+/** \brief Decode rows.
+
+    Read height rows of (width + 7) / 8 bytes plus padding bytes each into the strip buffer, 8 rows at a time, and draw every full (or final) strip with blitRowMajor(). Bottom-up images fill each strip from its last row, so strips are drawn bottom to top.
+*/
+int8_t MicroOLEDImage::drawRows(int16_t x, int16_t y, uint8_t padding, uint8_t format, bool bottomUp, uint8_t rop) {
+	uint8_t bytesPerRow = (width + 7) / 8;
+
+	if ((width == 0) || (height == 0) || (width > MAXIMAGEWIDTH) || (height > 0x7FFF))
+	return IMAGE_ERROR_SIZE;
+
+	for (uint16_t done = 0; done < height; ) {
+		uint8_t count = (height - done < 8) ? height - done : 8;
+		uint16_t top = bottomUp ? height - done - count : done;
+
+		for (uint8_t i = 0; i < count; i++) {
+			uint8_t row = bottomUp ? count - 1 - i : i;
+
+			if (!readBytes(strip + row * bytesPerRow, bytesPerRow) || !readBytes(NULL, padding))
+			return IMAGE_ERROR_READ;
+		}
+
+		oled.blitRowMajor(x, y + top, strip, width, count, format, rop);
+		done += count;
+	}
+	return IMAGE_OK;
+}
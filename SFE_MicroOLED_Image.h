@@ -0,0 +1,62 @@
+/******************************************************************************
+SFE_MicroOLED_Image.h
+Header file for the MicroOLED mbed Library image decoder
+
+This file defines a streaming decoder for 1bpp PBM (P4) and BMP images. The
+image is read from a FileHandle in small chunks and drawn into the screen
+buffer 8 rows at a time, so no full-size copy of the image is ever held in
+RAM.
+
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later
+version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#ifndef SFE_MICROOLED_IMAGE_H
+#define SFE_MICROOLED_IMAGE_H
+
+#include "SFE_MicroOLED.h"
+
+#define IMAGECHUNKSIZE		32		// Bytes read from the file at a time
+#define MAXIMAGEWIDTH		128		// Widest image that can be decoded, sets the strip buffer size
+
+// Results of MicroOLEDImage::draw()
+#define IMAGE_OK			0
+#define IMAGE_ERROR_READ	-1		// file ended early or could not be read
+#define IMAGE_ERROR_FORMAT	-2		// not a PBM P4 or uncompressed 1bpp BMP
+#define IMAGE_ERROR_SIZE	-3		// wider than MAXIMAGEWIDTH or empty
+
+class MicroOLEDImage {
+public:
+	MicroOLEDImage(MicroOLED &oled);
+
+	int8_t draw(FileHandle &file, int16_t x, int16_t y, uint8_t rop = ROP_COPY);
+	uint16_t getWidth(void);
+	uint16_t getHeight(void);
+
+private:
+	MicroOLED &oled;
+	FileHandle *file;
+	uint8_t chunk[IMAGECHUNKSIZE];
+	uint8_t chunkPos, chunkLen;
+	uint8_t strip[8 * (MAXIMAGEWIDTH / 8)];	// 8 row-major rows, one transpose block high
+	uint16_t width, height;
+
+	int16_t readByte(void);
+	bool readBytes(uint8_t *dst, uint32_t len);
+	bool readLE(uint32_t &value, uint8_t bytes);
+	bool readNumber(uint16_t &value);
+	int8_t drawPBM(int16_t x, int16_t y, uint8_t rop);
+	int8_t drawBMP(int16_t x, int16_t y, uint8_t rop);
+	int8_t drawRows(int16_t x, int16_t y, uint8_t padding, uint8_t format, bool bottomUp, uint8_t rop);
+};
+#endif
@@ -0,0 +1,145 @@
+/****************************************************************************** 
+SFE_MicroOLED_Number.cpp
+Numeric readout for the MicroOLED mbed Library
+
+This file implements a numeric readout for the large fonts (7-segment and
+large number). It remembers the digits on the display and only redraws and
+sends the digits that changed.
+
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software 
+Foundation, either version 3 of the License, or (at your option) any later 
+version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include "mbed.h"
+#include "SFE_MicroOLED_Number.h"
+
+/** \brief Create numeric readout.
+
+    The readout occupies cells character cells of font fontType, left to right from x,y. Only the 7-segment (2) and large number (3) fonts are supported: the bitmap rows of the other fonts are wider than blit() can address, so with any other fontType the readout has no cells and never draws anything. Nothing is drawn until render() is called.
+*/
+MicroOLEDNumber::MicroOLEDNumber(MicroOLED &oled, uint8_t fontType, int16_t x, int16_t y, uint8_t cells) : oled(oled), x(x), y(y)
+{
+	font = MicroOLED::getFontData(fontType);
+	if ((fontType != 2) && (fontType != 3)) {
+		font = MicroOLED::getFontData(2);	// keeps render() and setValue() harmless
+		cells = 0;
+	}
+	this->cells = (cells < MAXNUMBERDIGITS) ? cells : MAXNUMBERDIGITS;
+	leadingZeros = false;
+	memset(wanted, ' ', sizeof(wanted));
+	invalidate();
+}
+
+/** \brief Set value.
+
+    Show value right aligned. If it has more digits than the readout has cells only the lowest digits are shown.
+*/
+void MicroOLEDNumber::setValue(uint32_t value) {
+	setValue(value, 0);
+}
+
+/** \brief Set value with decimal point.
+
+    Show value right aligned with a '.' before its last decimals digits, e.g. 1234 with 2 decimals shows "12.34". The point takes a cell of its own, so this only makes sense with a font that has one (the 7-segment font).
+*/
+void MicroOLEDNumber::setValue(uint32_t value, uint8_t decimals) {
+	char text[MAXNUMBERDIGITS + 1];
+	int8_t i = cells;
+	uint8_t digits = 0, minDigits = decimals + 1;	// always show a digit before the point
+
+	text[i] = 0;
+	while (i > 0) {
+		if ((decimals > 0) && (digits == decimals)) {
+			text[--i] = '.';
+			decimals = 0;	// only one point
+			continue;
+		}
+		if ((value == 0) && (digits >= minDigits) && !leadingZeros)
+		break;
+		text[--i] = '0' + (value % 10);
+		value /= 10;
+		digits++;
+	}
+	while (i > 0) {
+		text[--i] = ' ';
+	}
+	setText(text);
+}
+
+/** \brief Set text.
+
+    Show the characters of text, e.g. "12:34" with the large number font, left aligned. Cells beyond the end of text are blank, characters the font does not have are drawn blank.
+*/
+void MicroOLEDNumber::setText(const char *text) {
+	for (uint8_t i = 0; i < cells; i++) {
+		wanted[i] = *text ? *text++ : ' ';
+	}
+}
+
+/** \brief Pad with zeros.
+
+    Fill unused cells on the left of setValue() numbers with zeros instead of blanks.
+*/
+void MicroOLEDNumber::setLeadingZeros(boolean zeros) {
+	leadingZeros = zeros;
+}
+
+/** \brief Redraw everything.
+
+    Forget what is on the display, so the next render() draws every cell.
+*/
+void MicroOLEDNumber::invalidate(void) {
+	memset(shown, 0, sizeof(shown));
+}
+
+/** \brief Render readout.
+
+    Draw the cells whose character differs from what is on the display and send each of them with its own address window. The readout follows the drawing rotation and the current viewport, which must not change between render() calls without invalidate(). With the 12x48 large number font a changed digit costs 72 data bytes.
+*/
+void MicroOLEDNumber::render(void) {
+	uint8_t width = font[0], height = font[1];
+
+	for (uint8_t i = 0; i < cells; i++) {
+		int16_t cellX = x + i * width, cellY = y, cellWidth = width, cellHeight = height;
+
+		if (wanted[i] == shown[i])
+		continue;
+
+		drawCell(i, wanted[i]);
+		oled.mapToPanel(cellX, cellY, cellWidth, cellHeight);
+		oled.display(cellX, cellY, cellWidth, cellHeight);
+		shown[i] = wanted[i];
+	}
+}
+
+/** \brief Draw one cell.
+
+    Blit the glyph for c from the font bitmap into the screen buffer, or clear the cell if the font has no such character.
+*/
+void MicroOLEDNumber::drawCell(uint8_t cell, char c) {
+	uint8_t width = font[0], height = font[1], start = font[2], total = font[3];
+	uint16_t mapWidth = (font[4] * 100) + font[5];
+	uint8_t code = (uint8_t)c;
+	uint8_t perRow, glyph;
+	int16_t cellX = x + cell * width;
+
+	if ((code < start) || (code >= start + total)) {
+		oled.rectFill(cellX, y, width, height, BLACK, NORM);
+		return;
+	}
+
+	// same bitmap arrangement as MicroOLED::drawChar(): rows of fontMapWidth bytes per page
+	glyph = code - start;
+	perRow = mapWidth / width;
+	oled.blit(cellX, y, font + FONTHEADERSIZE + (glyph / perRow) * mapWidth * (height / 8), mapWidth, height, (glyph % perRow) * width, 0, width, height, ROP_COPY);
+}
@@ -0,0 +1,57 @@
+/****************************************************************************** 
+SFE_MicroOLED_Number.h
+Header file for the MicroOLED mbed Library numeric readout
+
+This file defines a numeric readout for the large fonts (7-segment and large
+number). It remembers the digits on the display and only redraws and sends
+the digits that changed.
+
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software 
+Foundation, either version 3 of the License, or (at your option) any later 
+version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#ifndef SFE_MICROOLED_NUMBER_H
+#define SFE_MICROOLED_NUMBER_H
+
+#include "SFE_MicroOLED.h"
+
+#ifdef MICROOLED_PAGEMODE
+#error "MicroOLEDNumber needs the full screen buffer; not available with MICROOLED_PAGEMODE"
+#endif
+
+#define MAXNUMBERDIGITS		8	// Most character cells one readout can have
+
+class MicroOLEDNumber {
+public:
+	// Readout of cells characters of font fontType at x,y (only the numeric fonts 2 and 3)
+	MicroOLEDNumber(MicroOLED &oled, uint8_t fontType, int16_t x, int16_t y, uint8_t cells);
+
+	void setValue(uint32_t value);
+	void setValue(uint32_t value, uint8_t decimals);
+	void setText(const char *text);
+	void setLeadingZeros(boolean zeros);
+	void invalidate(void);
+	void render(void);
+
+private:
+	MicroOLED &oled;
+	const unsigned char *font;
+	int16_t x, y;
+	uint8_t cells;
+	boolean leadingZeros;
+	char wanted[MAXNUMBERDIGITS];	// characters to show, ' ' is blank
+	char shown[MAXNUMBERDIGITS];	// characters on the display, 0 if unknown
+
+	void drawCell(uint8_t cell, char c);
+};
+#endif
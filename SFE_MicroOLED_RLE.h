@@ -0,0 +1,152 @@
+/******************************************************************************
+SFE_MicroOLED_RLE.h
+Run-length image format for the MicroOLED mbed Library
+
+This file defines a PackBits style run-length encoding of page-major frames.
+Each run starts with a control byte c:
+	c < 0x80	c + 1 literal bytes follow (1 to 128)
+	c >= 0x80	the next byte is repeated (c - 0x80) + 2 times (2 to 129)
+A compressed image is the runs of one LCDWIDTH x LCDHEIGHT frame. An animation
+is a frame count byte followed by the frames; the first frame is a full image,
+every later frame is the XOR of itself with the frame before, so unchanged
+areas become long runs of zeros. The encoder and decoder only need
+<stdint.h>, so host tools use the same code as the device.
+
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later
+version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#ifndef SFE_MICROOLED_RLE_H
+#define SFE_MICROOLED_RLE_H
+
+#include <stdint.h>
+
+#define RLE_MAXLITERAL		128
+#define RLE_MINREPEAT		3		// shorter repeats are cheaper inside a literal run
+#define RLE_MAXREPEAT		129
+#define RLE_MAXSIZE(len)	((len) + ((len) + RLE_MAXLITERAL - 1) / RLE_MAXLITERAL)	// worst case encoded size
+
+/** \brief Run-length encode.
+
+    Encode len bytes of src into dst, which must hold RLE_MAXSIZE(len) bytes. Return the encoded size.
+*/
+static inline uint16_t rleEncode(const uint8_t *src, uint16_t len, uint8_t *dst) {
+	uint16_t in = 0, out = 0;
+
+	while (in < len) {
+		uint16_t repeat = 1;
+
+		while ((in + repeat < len) && (src[in + repeat] == src[in]) && (repeat < RLE_MAXREPEAT)) repeat++;
+		if (repeat >= RLE_MINREPEAT) {
+			dst[out++] = 0x80 + (repeat - 2);
+			dst[out++] = src[in];
+			in += repeat;
+			continue;
+		}
+
+		// literal run up to the next repeat worth encoding
+		uint16_t start = in, count = 0;
+		while ((in < len) && (count < RLE_MAXLITERAL)) {
+			if ((in + 2 < len) && (src[in] == src[in + 1]) && (src[in] == src[in + 2]))
+			break;
+			in++;
+			count++;
+		}
+		dst[out++] = count - 1;
+		for (uint16_t i = 0; i < count; i++) {
+			dst[out++] = src[start + i];
+		}
+	}
+	return out;
+}
+
+// Run-length decoder position, so a frame can be decoded a piece at a time
+struct RLEDecoder {
+	const uint8_t *src;		// next input byte
+	uint8_t left;			// bytes left in the current run
+	bool repeat;			// the current run repeats value, otherwise its bytes are at src
+	uint8_t value;
+};
+
+/** \brief Start run-length decoding.
+
+    Set up decoder to decode the runs at src.
+*/
+static inline void rleBegin(RLEDecoder &decoder, const uint8_t *src) {
+	decoder.src = src;
+	decoder.left = 0;
+	decoder.repeat = false;
+	decoder.value = 0;
+}
+
+/** \brief Run-length decode a piece.
+
+    Decode the next len bytes into dst, replacing dst or, if xorDst is set, XORing into it (for animation delta frames). Runs may continue across calls.
+*/
+static inline void rleRead(RLEDecoder &decoder, uint8_t *dst, uint16_t len, bool xorDst) {
+	uint16_t out = 0;
+
+	while (out < len) {
+		uint16_t n;
+
+		if (decoder.left == 0) {
+			uint8_t c = *decoder.src++;
+
+			decoder.repeat = (c >= 0x80);
+			if (decoder.repeat) {
+				decoder.left = (c - 0x80) + 2;
+				decoder.value = *decoder.src++;
+			}
+			else
+			decoder.left = c + 1;
+		}
+
+		n = decoder.left;
+		if (n > len - out) n = len - out;
+		if (decoder.repeat) {
+			for (uint16_t i = 0; i < n; i++) {
+				dst[out + i] = xorDst ? (dst[out + i] ^ decoder.value) : decoder.value;
+			}
+		}
+		else {
+			for (uint16_t i = 0; i < n; i++) {
+				dst[out + i] = xorDst ? (dst[out + i] ^ decoder.src[i]) : decoder.src[i];
+			}
+			decoder.src += n;
+		}
+		decoder.left -= n;
+		out += n;
+	}
+}
+
+/** \brief End run-length decoding.
+
+    Return a pointer just past the input consumed by decoder, skipping the rest of a run cut short by the end of the frame, i.e. to the next frame of an animation.
+*/
+static inline const uint8_t *rleEnd(const RLEDecoder &decoder) {
+	return decoder.repeat ? decoder.src : decoder.src + decoder.left;
+}
+
+/** \brief Run-length decode.
+
+    Decode runs from src until len bytes have been written to dst, replacing dst or, if xorDst is set, XORing into it (for animation delta frames). Return a pointer just past the consumed input, i.e. to the next frame of an animation.
+*/
+static inline const uint8_t *rleDecode(const uint8_t *src, uint8_t *dst, uint16_t len, bool xorDst) {
+	RLEDecoder decoder;
+
+	rleBegin(decoder, src);
+	rleRead(decoder, dst, len, xorDst);
+	return rleEnd(decoder);
+}
+
+#endif
@@ -0,0 +1,213 @@
+/****************************************************************************** 
+SFE_MicroOLED_Sprites.cpp
+Sprite layer for the MicroOLED mbed Library
+
+This file implements a sprite layer that moves small masked bitmaps over a
+saved background. Only the area around sprites that changed is redrawn and
+sent to the display.
+
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software 
+Foundation, either version 3 of the License, or (at your option) any later 
+version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include "mbed.h"
+#include "SFE_MicroOLED_Sprites.h"
+
+/** \brief Rectangle overlap test.
+*/
+static inline bool overlaps(int16_t x0, int16_t y0, uint8_t w0, uint8_t h0, int16_t x1, int16_t y1, uint8_t w1, uint8_t h1) {
+	return (x0 < x1 + w1) && (x1 < x0 + w0) && (y0 < y1 + h1) && (y1 < y0 + h0);
+}
+
+/** \brief Save background.
+
+    Copy the current screen buffer as the background sprites are drawn over. Draw the static scene, call saveBackground(), then display() it once before adding or moving sprites.
+*/
+void MicroOLEDSprites::saveBackground(void) {
+	memcpy(background, oled.getScreenBuffer(), sizeof(background));
+}
+
+/** \brief Get background buffer.
+
+    Return a pointer to the saved background for direct changes. Areas changed this way are not redrawn until a sprite passes over them.
+*/
+uint8_t *MicroOLEDSprites::getBackground(void) {
+	return background;
+}
+
+/** \brief Add sprite.
+
+    Add a width x height sprite at x,y. bitmap and mask use the screen buffer's page-major layout; only pixels set in mask are drawn, a NULL mask draws the whole rectangle. Sprites added later are drawn on top. Return the sprite id, or -1 if MAXSPRITES sprites already exist.
+*/
+int8_t MicroOLEDSprites::add(const uint8_t *bitmap, const uint8_t *mask, uint8_t width, uint8_t height, int16_t x, int16_t y) {
+	if (count >= MAXSPRITES)
+	return -1;
+
+	Sprite &s = sprites[count];
+	s.bitmap = bitmap;
+	s.mask = mask;
+	s.width = width;
+	s.height = height;
+	s.x = x;
+	s.y = y;
+	s.lastX = x;
+	s.lastY = y;
+	s.visible = true;
+	s.drawn = false;
+	s.changed = true;
+	return count++;
+}
+
+/** \brief Move sprite.
+
+    Set the position sprite id is drawn at on the next update().
+*/
+void MicroOLEDSprites::move(uint8_t id, int16_t x, int16_t y) {
+	if (id >= count)
+	return;
+
+	if ((sprites[id].x != x) || (sprites[id].y != y)) {
+		sprites[id].x = x;
+		sprites[id].y = y;
+		sprites[id].changed = true;
+	}
+}
+
+/** \brief Change sprite image.
+
+    Replace the bitmap and mask of sprite id, e.g. to step through animation frames. The new image must have the sprite's size.
+*/
+void MicroOLEDSprites::setImage(uint8_t id, const uint8_t *bitmap, const uint8_t *mask) {
+	if (id >= count)
+	return;
+
+	if ((sprites[id].bitmap != bitmap) || (sprites[id].mask != mask)) {
+		sprites[id].bitmap = bitmap;
+		sprites[id].mask = mask;
+		sprites[id].changed = true;
+	}
+}
+
+/** \brief Show or hide sprite.
+*/
+void MicroOLEDSprites::show(uint8_t id, boolean visible) {
+	if ((id >= count) || (sprites[id].visible == visible))
+	return;
+
+	sprites[id].visible = visible;
+	sprites[id].changed = true;
+}
+
+/** \brief Update sprites on the display.
+
+    Restore the background under every changed sprite's last position, redraw changed sprites and any sprite overlapping a redrawn area (keeping their stacking order), then send the union of those areas to the display with MicroOLED::displayDirty(). Sprite positions are drawing coordinates and follow the rotation and the current viewport; neither may change between update() calls.
+*/
+void MicroOLEDSprites::update(void) {
+	bool erased[MAXSPRITES], redraw[MAXSPRITES];
+	struct {
+		int16_t x, y;
+		uint8_t width, height;
+	} old[MAXSPRITES];		// rectangles erased, a sprite redrawn below must not move them before the sprites above are checked
+	uint8_t i, j;
+
+	// erase changed sprites from their old position
+	for (i = 0; i < count; i++) {
+		Sprite &s = sprites[i];
+		erased[i] = s.changed && s.drawn;
+		redraw[i] = false;
+		if (erased[i]) {
+			old[i].x = s.lastX;
+			old[i].y = s.lastY;
+			old[i].width = s.width;
+			old[i].height = s.height;
+			restore(s.lastX, s.lastY, s.width, s.height);
+			markDirty(s.lastX, s.lastY, s.width, s.height);
+			s.drawn = false;
+		}
+	}
+
+	// redraw changed sprites and whatever an erase or redraw damaged, bottom to top
+	for (i = 0; i < count; i++) {
+		Sprite &s = sprites[i];
+		if (!s.visible)
+		continue;
+
+		redraw[i] = s.changed;
+		for (j = 0; (j < count) && !redraw[i]; j++) {
+			Sprite &o = sprites[j];
+			if (erased[j] && overlaps(s.x, s.y, s.width, s.height, old[j].x, old[j].y, old[j].width, old[j].height))
+			redraw[i] = true;
+			if ((j < i) && redraw[j] && overlaps(s.x, s.y, s.width, s.height, o.x, o.y, o.width, o.height))
+			redraw[i] = true;
+		}
+		if (redraw[i]) {
+			oled.drawBitmap(s.x, s.y, s.bitmap, s.mask, s.width, s.height);
+			markDirty(s.x, s.y, s.width, s.height);
+			s.drawn = true;
+		}
+	}
+
+	for (i = 0; i < count; i++) {
+		Sprite &s = sprites[i];
+		if (redraw[i]) {
+			s.lastX = s.x;
+			s.lastY = s.y;
+		}
+		s.changed = false;
+	}
+	oled.displayDirty();
+}
+
+/** \brief Restore background.
+
+    Copy the pixels of the width x height rectangle at x,y (drawing coordinates) from the saved background into the screen buffer, clipped to the screen. Both buffers are in panel coordinates, so the rectangle is mapped to the panel and copied a page byte at a time with page masks.
+*/
+void MicroOLEDSprites::restore(int16_t x, int16_t y, uint8_t width, uint8_t height) {
+	uint8_t *screen = oled.getScreenBuffer();
+	int16_t w = width, h = height;
+
+	oled.mapToPanel(x, y, w, h);
+	if (x < 0) {
+		w += x;
+		x = 0;
+	}
+	if (y < 0) {
+		h += y;
+		y = 0;
+	}
+	if (w > LCDWIDTH - x) w = LCDWIDTH - x;
+	if (h > LCDHEIGHT - y) h = LCDHEIGHT - y;
+	if ((w <= 0) || (h <= 0))
+	return;
+
+	for (uint8_t page = y / 8; page <= (y + h - 1) / 8; page++) {
+		uint8_t mask = 0xFF;
+		if (page == y / 8) mask &= 0xFF << (y % 8);
+		if (page == (y + h - 1) / 8) mask &= 0xFF >> (7 - (y + h - 1) % 8);
+
+		for (uint16_t i = page * LCDWIDTH + x; i < page * LCDWIDTH + x + w; i++) {
+			screen[i] = (screen[i] & ~mask) | (background[i] & mask);
+		}
+	}
+}
+
+/** \brief Mark sprite area dirty.
+
+    Add the width x height rectangle at x,y (drawing coordinates) to the display's dirty region.
+*/
+void MicroOLEDSprites::markDirty(int16_t x, int16_t y, uint8_t width, uint8_t height) {
+	int16_t w = width, h = height;
+
+	oled.mapToPanel(x, y, w, h);
+	oled.markDirty(x, y, w, h);
+}
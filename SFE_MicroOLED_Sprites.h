@@ -0,0 +1,66 @@
+/****************************************************************************** 
+SFE_MicroOLED_Sprites.h
+Header file for the MicroOLED mbed Library sprite layer
+
+This file defines a sprite layer that moves small masked bitmaps over a saved
+background. Only the area around sprites that changed is redrawn and sent to
+the display.
+
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software 
+Foundation, either version 3 of the License, or (at your option) any later 
+version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#ifndef SFE_MICROOLED_SPRITES_H
+#define SFE_MICROOLED_SPRITES_H
+
+#include "SFE_MicroOLED.h"
+
+#ifdef MICROOLED_PAGEMODE
+#error "MicroOLEDSprites needs the full screen buffer; not available with MICROOLED_PAGEMODE"
+#endif
+
+#define MAXSPRITES			8
+
+class MicroOLEDSprites {
+public:
+	MicroOLEDSprites(MicroOLED &oled) : oled(oled), count(0) {};
+
+	// Background handling
+	void saveBackground(void);
+	uint8_t *getBackground(void);
+
+	// Sprite functions
+	int8_t add(const uint8_t *bitmap, const uint8_t *mask, uint8_t width, uint8_t height, int16_t x, int16_t y);
+	void move(uint8_t id, int16_t x, int16_t y);
+	void setImage(uint8_t id, const uint8_t *bitmap, const uint8_t *mask);
+	void show(uint8_t id, boolean visible);
+	void update(void);
+
+private:
+	struct Sprite {
+		const uint8_t *bitmap, *mask;
+		uint8_t width, height;
+		int16_t x, y;			// position to draw at on next update()
+		int16_t lastX, lastY;	// position drawn at on the display
+		bool visible, drawn, changed;
+	};
+
+	MicroOLED &oled;
+	uint8_t background[LCDWIDTH * LCDHEIGHT / 8];
+	Sprite sprites[MAXSPRITES];
+	uint8_t count;
+
+	void restore(int16_t x, int16_t y, uint8_t width, uint8_t height);
+	void markDirty(int16_t x, int16_t y, uint8_t width, uint8_t height);
+};
+#endif
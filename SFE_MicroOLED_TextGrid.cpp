@@ -0,0 +1,179 @@
+/****************************************************************************** 
+SFE_MicroOLED_TextGrid.cpp
+Text grid for the MicroOLED mbed Library
+
+This file implements a character-cell text mode using the 5x7 font. The text
+is kept in a character array; only cells whose character changed are rendered
+and sent to the display.
+
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software 
+Foundation, either version 3 of the License, or (at your option) any later 
+version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include "mbed.h"
+#include <stdarg.h>
+#include "SFE_MicroOLED_TextGrid.h"
+
+#define ALLCOLUMNS		((1 << TEXTGRIDCOLUMNS) - 1)
+
+/** \brief Clear text grid.
+
+    Fill every cell with a space and move the cursor home. Only cells that were not blank are redrawn.
+*/
+void MicroOLEDTextGrid::clear(void) {
+	for (uint8_t row = 0; row < TEXTGRIDROWS; row++) {
+		for (uint8_t col = 0; col < TEXTGRIDCOLUMNS; col++) {
+			setChar(col, row, ' ');
+		}
+	}
+	setCursor(0, 0);
+}
+
+/** \brief Set cursor position.
+
+    Move the text cursor to cell col,row.
+*/
+void MicroOLEDTextGrid::setCursor(uint8_t col, uint8_t row) {
+	cursorCol = (col < TEXTGRIDCOLUMNS) ? col : 0;
+	cursorRow = (row < TEXTGRIDROWS) ? row : 0;
+}
+
+/** \brief Set character.
+
+    Put c into cell col,row. The cell is only redrawn if its character actually changes.
+*/
+void MicroOLEDTextGrid::setChar(uint8_t col, uint8_t row, char c) {
+	if ((col >= TEXTGRIDCOLUMNS) || (row >= TEXTGRIDROWS) || (text[row][col] == c))
+	return;
+
+	text[row][col] = c;
+	dirty[row] |= 1 << col;
+}
+
+/** \brief Get character.
+
+    Return the character in cell col,row.
+*/
+char MicroOLEDTextGrid::getChar(uint8_t col, uint8_t row) {
+	if ((col >= TEXTGRIDCOLUMNS) || (row >= TEXTGRIDROWS))
+	return 0;
+
+	return text[row][col];
+}
+
+/*
+    Classic text print functions, writing at the cursor. Text wraps at the right edge and scrolls up at the bottom.
+*/
+
+void MicroOLEDTextGrid::putc(char c) {
+	if (c == '\n') {
+		newline();
+	} else if (c == '\r') {
+		cursorCol = 0;
+	} else {
+		if (cursorCol >= TEXTGRIDCOLUMNS)
+		newline();
+		setChar(cursorCol++, cursorRow, c);
+	}
+}
+
+void MicroOLEDTextGrid::puts(const char *cstring) {
+	while (*cstring != 0) {
+		putc(*cstring++);
+	}
+}
+
+void MicroOLEDTextGrid::printf(const char *format, ...) {
+	char buffer[TEXTGRIDROWS * TEXTGRIDCOLUMNS + 1];
+
+	va_list args;
+	va_start(args, format);
+	vsnprintf(buffer, sizeof(buffer), format, args);
+	va_end(args);
+
+	puts(buffer);
+}
+
+/** \brief Move cursor to the next line.
+
+    At the bottom row the text scrolls up one row; only cells whose character differs from the one below them are redrawn.
+*/
+void MicroOLEDTextGrid::newline(void) {
+	cursorCol = 0;
+	if (cursorRow < TEXTGRIDROWS - 1) {
+		cursorRow++;
+		return;
+	}
+
+	for (uint8_t row = 0; row < TEXTGRIDROWS; row++) {
+		for (uint8_t col = 0; col < TEXTGRIDCOLUMNS; col++) {
+			setChar(col, row, (row < TEXTGRIDROWS - 1) ? text[row + 1][col] : ' ');
+		}
+	}
+}
+
+/** \brief Redraw everything.
+
+    Mark every cell for redraw, e.g. after something else has drawn over the screen buffer.
+*/
+void MicroOLEDTextGrid::invalidate(void) {
+	for (uint8_t row = 0; row < TEXTGRIDROWS; row++) {
+		dirty[row] = ALLCOLUMNS;
+	}
+}
+
+/** \brief Render text grid.
+
+    Draw the glyphs of changed cells straight into the screen buffer and send them to the display. Adjacent changed cells in a row share one address window, so changing one character costs 6 data bytes and one window command.
+*/
+void MicroOLEDTextGrid::render(void) {
+	uint8_t *screen = oled.getScreenBuffer();
+	uint8_t row, col, first;
+
+	for (row = 0; row < TEXTGRIDROWS; row++) {
+		if (!dirty[row])
+		continue;
+
+		col = 0;
+		while (col < TEXTGRIDCOLUMNS) {
+			if (!(dirty[row] & (1 << col))) {
+				col++;
+				continue;
+			}
+			first = col;
+			while ((col < TEXTGRIDCOLUMNS) && (dirty[row] & (1 << col))) {
+				drawCell(screen + row * LCDWIDTH + col * TEXTCELLWIDTH, text[row][col]);
+				col++;
+			}
+			oled.display(first * TEXTCELLWIDTH, row * TEXTCELLHEIGHT, (col - first) * TEXTCELLWIDTH, TEXTCELLHEIGHT);
+		}
+		dirty[row] = 0;
+	}
+}
+
+/** \brief Draw one cell.
+
+    Copy the 5x7 glyph for c and its blank gap column into the screen buffer at dst. Characters missing from the font are drawn blank.
+*/
+void MicroOLEDTextGrid::drawCell(uint8_t *dst, char c) {
+	const unsigned char *font = MicroOLED::getFontData(0);
+	uint8_t width = font[0], start = font[2], total = font[3];
+	uint8_t code = (uint8_t)c;
+
+	if ((code < start) || (code >= start + total)) {
+		memset(dst, 0, TEXTCELLWIDTH);
+		return;
+	}
+	memcpy(dst, font + FONTHEADERSIZE + (code - start) * width, width);
+	dst[width] = 0;
+}
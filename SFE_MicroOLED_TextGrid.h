@@ -0,0 +1,69 @@
+/****************************************************************************** 
+SFE_MicroOLED_TextGrid.h
+Header file for the MicroOLED mbed Library text grid
+
+This file defines a character-cell text mode using the 5x7 font. The text is
+kept in a character array; only cells whose character changed are rendered
+and sent to the display.
+
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software 
+Foundation, either version 3 of the License, or (at your option) any later 
+version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#ifndef SFE_MICROOLED_TEXTGRID_H
+#define SFE_MICROOLED_TEXTGRID_H
+
+#include "SFE_MicroOLED.h"
+
+#ifdef MICROOLED_PAGEMODE
+#error "MicroOLEDTextGrid needs the full screen buffer; not available with MICROOLED_PAGEMODE"
+#endif
+
+#define TEXTCELLWIDTH		6	// 5 pixel glyph plus 1 pixel gap
+#define TEXTCELLHEIGHT		8	// one display page
+#define TEXTGRIDCOLUMNS		(LCDWIDTH / TEXTCELLWIDTH)
+#define TEXTGRIDROWS		(LCDHEIGHT / TEXTCELLHEIGHT)
+
+class MicroOLEDTextGrid {
+public:
+	MicroOLEDTextGrid(MicroOLED &oled) : oled(oled)
+	{
+		memset(text, 0, sizeof(text));
+		memset(dirty, 0, sizeof(dirty));
+		clear();
+		invalidate();	// the screen buffer may hold anything, repaint every cell on the first render()
+	};
+
+	// Text output functions
+	void clear(void);
+	void setCursor(uint8_t col, uint8_t row);
+	void setChar(uint8_t col, uint8_t row, char c);
+	char getChar(uint8_t col, uint8_t row);
+	void putc(char c);
+	void puts(const char *cstring);
+	void printf(const char *format, ...);
+
+	// Display update functions
+	void invalidate(void);
+	void render(void);
+
+private:
+	MicroOLED &oled;
+	char text[TEXTGRIDROWS][TEXTGRIDCOLUMNS];
+	uint16_t dirty[TEXTGRIDROWS];	// one bit per column, set when the cell must be redrawn
+	uint8_t cursorCol, cursorRow;
+
+	void newline(void);
+	void drawCell(uint8_t *dst, char c);
+};
+#endif
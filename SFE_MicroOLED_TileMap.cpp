@@ -0,0 +1,119 @@
+/****************************************************************************** 
+SFE_MicroOLED_TileMap.cpp
+Tile map for the MicroOLED mbed Library
+
+This file implements a tile map mode in which the screen is a grid of 8x8
+pixel tiles, one display page high, taken from a tileset. Only cells whose
+tile changed are copied into the screen buffer and sent to the display.
+
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software 
+Foundation, either version 3 of the License, or (at your option) any later 
+version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include "mbed.h"
+#include "SFE_MicroOLED_TileMap.h"
+
+/** \brief Set tileset.
+
+    Use a different tileset and redraw every cell on the next render(). A tileset is an array of 8-byte tiles in the screen buffer's page-major layout: byte i is column i of the tile, bit 0 its top pixel.
+*/
+void MicroOLEDTileMap::setTileset(const uint8_t *tileset) {
+	this->tileset = tileset;
+	invalidate();
+}
+
+/** \brief Set tile.
+
+    Show tile number tile at grid cell col,row. The cell is only redrawn if its tile actually changes.
+*/
+void MicroOLEDTileMap::setTile(uint8_t col, uint8_t row, uint8_t tile) {
+	if ((col >= TILEMAPCOLUMNS) || (row >= TILEMAPROWS) || (tiles[row][col] == tile))
+	return;
+
+	tiles[row][col] = tile;
+	dirty[row] |= 1 << col;
+}
+
+/** \brief Get tile.
+
+    Return the tile number at grid cell col,row.
+*/
+uint8_t MicroOLEDTileMap::getTile(uint8_t col, uint8_t row) {
+	if ((col >= TILEMAPCOLUMNS) || (row >= TILEMAPROWS))
+	return 0;
+
+	return tiles[row][col];
+}
+
+/** \brief Fill tile map.
+
+    Set every cell to tile and redraw all of them on the next render().
+*/
+void MicroOLEDTileMap::fill(uint8_t tile) {
+	memset(tiles, tile, sizeof(tiles));
+	invalidate();
+}
+
+/** \brief Redraw everything.
+
+    Mark every cell for redraw, e.g. after something else has drawn over the screen buffer.
+*/
+void MicroOLEDTileMap::invalidate(void) {
+	for (uint8_t row = 0; row < TILEMAPROWS; row++) {
+		dirty[row] = (1 << TILEMAPCOLUMNS) - 1;
+	}
+}
+
+/** \brief Render tile map.
+
+    Copy the tiles of changed cells into the screen buffer (8 bytes each) and send them to the display. Adjacent changed cells in a row share one address window, so a single changed cell costs 8 data bytes and one window command; a fully changed map is sent as one frame.
+*/
+void MicroOLEDTileMap::render(void) {
+	uint8_t *screen = oled.getScreenBuffer();
+	uint8_t row, col, first;
+	bool all = true;
+
+	for (row = 0; row < TILEMAPROWS; row++) {
+		all = all && (dirty[row] == (1 << TILEMAPCOLUMNS) - 1);
+	}
+	if (all) {	// one full frame beats a window per row
+		for (row = 0; row < TILEMAPROWS; row++) {
+			for (col = 0; col < TILEMAPCOLUMNS; col++) {
+				memcpy(screen + row * LCDWIDTH + col * TILESIZE, tileset + tiles[row][col] * TILESIZE, TILESIZE);
+			}
+			dirty[row] = 0;
+		}
+		oled.display();
+		return;
+	}
+
+	for (row = 0; row < TILEMAPROWS; row++) {
+		if (!dirty[row])
+		continue;
+
+		col = 0;
+		while (col < TILEMAPCOLUMNS) {
+			if (!(dirty[row] & (1 << col))) {
+				col++;
+				continue;
+			}
+			first = col;
+			while ((col < TILEMAPCOLUMNS) && (dirty[row] & (1 << col))) {
+				memcpy(screen + row * LCDWIDTH + col * TILESIZE, tileset + tiles[row][col] * TILESIZE, TILESIZE);
+				col++;
+			}
+			oled.display(first * TILESIZE, row * TILESIZE, (col - first) * TILESIZE, TILESIZE);
+		}
+		dirty[row] = 0;
+	}
+}
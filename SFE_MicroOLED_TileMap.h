@@ -0,0 +1,56 @@
+/****************************************************************************** 
+SFE_MicroOLED_TileMap.h
+Header file for the MicroOLED mbed Library tile map
+
+This file defines a tile map mode in which the screen is a grid of 8x8 pixel
+tiles, one display page high, taken from a tileset. Only cells whose tile
+changed are copied into the screen buffer and sent to the display.
+
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software 
+Foundation, either version 3 of the License, or (at your option) any later 
+version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#ifndef SFE_MICROOLED_TILEMAP_H
+#define SFE_MICROOLED_TILEMAP_H
+
+#include "SFE_MicroOLED.h"
+
+#ifdef MICROOLED_PAGEMODE
+#error "MicroOLEDTileMap needs the full screen buffer; not available with MICROOLED_PAGEMODE"
+#endif
+
+#define TILESIZE			8						// Tile width and height in pixels, height is one display page
+#define TILEMAPCOLUMNS		(LCDWIDTH / TILESIZE)
+#define TILEMAPROWS			(LCDHEIGHT / TILESIZE)
+
+class MicroOLEDTileMap {
+public:
+	MicroOLEDTileMap(MicroOLED &oled, const uint8_t *tileset) : oled(oled), tileset(tileset)
+	{
+		fill(0);
+	};
+
+	void setTileset(const uint8_t *tileset);
+	void setTile(uint8_t col, uint8_t row, uint8_t tile);
+	uint8_t getTile(uint8_t col, uint8_t row);
+	void fill(uint8_t tile);
+	void invalidate(void);
+	void render(void);
+
+private:
+	MicroOLED &oled;
+	const uint8_t *tileset;
+	uint8_t tiles[TILEMAPROWS][TILEMAPCOLUMNS];
+	uint16_t dirty[TILEMAPROWS];	// one bit per column, set when the cell must be redrawn
+};
+#endif
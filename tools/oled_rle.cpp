@@ -0,0 +1,138 @@
+/******************************************************************************
+oled_rle.cpp
+Host-side image and animation encoder for the MicroOLED mbed Library
+
+This program converts 64x48 PBM (P4) images into the run-length format of
+SFE_MicroOLED_RLE.h and prints them as a C array. One input file gives an
+image for drawRLE()/displayRLE(); several give an animation: a frame count
+byte, the first frame, then each further frame XORed with the one before.
+With -delta, the frames are written as an animation in the delta frame format
+of SFE_MicroOLED_Delta.h for MicroOLEDAnimation instead. Build on the host
+with e.g.
+
+	g++ -O2 -I.. -o oled_rle oled_rle.cpp
+
+and run as
+
+	oled_rle [-delta] name frame0.pbm [frame1.pbm ...] > name.h
+
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later
+version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "SFE_MicroOLED_Bits.h"
+#include "SFE_MicroOLED_RLE.h"
+#include "SFE_MicroOLED_Delta.h"
+
+#define WIDTH		64
+#define HEIGHT		48
+#define FRAMESIZE	(WIDTH * HEIGHT / 8)
+#define MAXFRAMES	255
+
+/** \brief Read PBM header number.
+
+    Skip white space and comments, then read a decimal number. Return -1 on error.
+*/
+static int readNumber(FILE *f) {
+	int c, value = 0;
+
+	do {
+		c = fgetc(f);
+		if (c == '#') {
+			while ((c != '\n') && (c != EOF)) c = fgetc(f);
+		}
+	} while ((c == ' ') || (c == '\t') || (c == '\r') || (c == '\n'));
+	if ((c < '0') || (c > '9'))
+	return -1;
+	while ((c >= '0') && (c <= '9')) {
+		value = value * 10 + (c - '0');
+		c = fgetc(f);
+	}
+	return value;	// c is the single white space before the raster
+}
+
+/** \brief Load frame.
+
+    Read a WIDTH x HEIGHT binary PBM file into frame in page-major layout. Return false with a message on error.
+*/
+static bool loadFrame(const char *name, uint8_t *frame) {
+	uint8_t raster[(WIDTH / 8) * HEIGHT];
+	FILE *f = fopen(name, "rb");
+	bool ok = false;
+
+	if (f == NULL) {
+		fprintf(stderr, "%s: cannot open\n", name);
+		return false;
+	}
+	if ((fgetc(f) != 'P') || (fgetc(f) != '4'))
+	fprintf(stderr, "%s: not a binary PBM (P4) file\n", name);
+	else if ((readNumber(f) != WIDTH) || (readNumber(f) != HEIGHT))
+	fprintf(stderr, "%s: image must be %dx%d\n", name, WIDTH, HEIGHT);
+	else if (fread(raster, 1, sizeof(raster), f) != sizeof(raster))
+	fprintf(stderr, "%s: short raster\n", name);
+	else {
+		rowMajorToPageMajor(raster, frame, WIDTH, HEIGHT, IMAGE_PBM);
+		ok = true;
+	}
+	fclose(f);
+	return ok;
+}
+
+int main(int argc, char **argv) {
+	static uint8_t frame[2][FRAMESIZE], first[FRAMESIZE];
+	static uint8_t out[DELTA_MAXSIZE(WIDTH, HEIGHT / 8) * (MAXFRAMES + 1) + 1];
+	uint32_t size = 0;
+	bool delta = (argc > 1) && (strcmp(argv[1], "-delta") == 0);
+	int arg = delta ? 2 : 1;
+	int frames = argc - arg - 1;
+
+	if ((frames < 1) || (frames > MAXFRAMES)) {
+		fprintf(stderr, "usage: %s [-delta] name frame0.pbm [frame1.pbm ...]\n", argv[0]);
+		return 1;
+	}
+
+	if (delta || (frames > 1))
+	out[size++] = frames;
+	memset(frame, 0, sizeof(frame));	// delta frames start from a blank screen
+	for (int i = 0; i < frames; i++) {
+		uint8_t *cur = frame[i & 1], *prev = frame[(i & 1) ^ 1];
+		uint8_t diff[FRAMESIZE];
+
+		if (!loadFrame(argv[arg + 1 + i], cur))
+		return 1;
+		if (delta) {
+			size += deltaEncode(prev, cur, WIDTH, HEIGHT / 8, out + size);
+		}
+		else {
+			for (int j = 0; j < FRAMESIZE; j++) {
+				diff[j] = (i > 0) ? (cur[j] ^ prev[j]) : cur[j];
+			}
+			size += rleEncode(diff, FRAMESIZE, out + size);
+		}
+		if (i == 0)
+		memcpy(first, cur, FRAMESIZE);
+	}
+	if (delta)	// loop record back to the first frame
+	size += deltaEncode(frame[(frames - 1) & 1], first, WIDTH, HEIGHT / 8, out + size);
+
+	printf("// %d frame%s, %u bytes (%u uncompressed)\n", frames, (frames > 1) ? "s" : "", (unsigned)size, (unsigned)(frames * FRAMESIZE));
+	printf("static const uint8_t %s[] = {", argv[arg]);
+	for (uint32_t i = 0; i < size; i++) {
+		printf("%s0x%02X,", (i % 16) ? " " : "\n\t", out[i]);
+	}
+	printf("\n};\n");
+	return 0;
+}